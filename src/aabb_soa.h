@@ -0,0 +1,218 @@
+#pragma once
+#include "bounds.h"
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+//boxes stored as one min and one max array per axis, so the kernels test 8 (avx2) or 4 (sse2) boxes per instruction
+class aabb_soa
+{
+public:
+	std::size_t size() const
+	{
+		return lo[0].size();
+	}
+
+	bool empty() const
+	{
+		return lo[0].empty();
+	}
+
+	void reserve(std::size_t n)
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			lo[a].reserve(n);
+			hi[a].reserve(n);
+		}
+	}
+
+	void clear()
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			lo[a].clear();
+			hi[a].clear();
+		}
+	}
+
+	void push_back(const bounding_box &b)
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			lo[a].push_back(b.min[a]);
+			hi[a].push_back(b.max[a]);
+		}
+	}
+
+	bounding_box operator[](std::size_t i) const
+	{
+		glm::vec3 mn(lo[0][i], lo[1][i], lo[2][i]);
+		return bounding_box(mn, glm::vec3(hi[0][i], hi[1][i], hi[2][i]) - mn);
+	}
+
+	//bit i is set if box first + i collides with b (same test as bounding_box::collides), count must be at most 64
+	std::uint64_t overlap_mask(const bounding_box &b, std::size_t first, std::size_t count) const
+	{
+		std::uint64_t mask = 0;
+		std::size_t i = 0;
+
+#if defined(__AVX2__)
+		__m256 bmin[3];
+		__m256 bmax[3];
+		for (int a = 0; a < 3; ++a)
+		{
+			bmin[a] = _mm256_set1_ps(b.min[a]);
+			bmax[a] = _mm256_set1_ps(b.max[a]);
+		}
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 hit = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int a = 0; a < 3; ++a)
+			{
+				__m256 smin = _mm256_loadu_ps(lo[a].data() + first + i);
+				__m256 smax = _mm256_loadu_ps(hi[a].data() + first + i);
+				hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_max_ps(bmin[a], smin), _mm256_min_ps(bmax[a], smax), _CMP_LE_OQ));
+			}
+			mask |= std::uint64_t(_mm256_movemask_ps(hit)) << i;
+		}
+#elif defined(__SSE2__) || defined(_M_X64)
+		__m128 bmin[3];
+		__m128 bmax[3];
+		for (int a = 0; a < 3; ++a)
+		{
+			bmin[a] = _mm_set1_ps(b.min[a]);
+			bmax[a] = _mm_set1_ps(b.max[a]);
+		}
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 hit = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int a = 0; a < 3; ++a)
+			{
+				__m128 smin = _mm_loadu_ps(lo[a].data() + first + i);
+				__m128 smax = _mm_loadu_ps(hi[a].data() + first + i);
+				hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_max_ps(bmin[a], smin), _mm_min_ps(bmax[a], smax)));
+			}
+			mask |= std::uint64_t(_mm_movemask_ps(hit)) << i;
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			std::size_t s = first + i;
+			if (bounding_box::collides(b.min.x, b.max.x, lo[0][s], hi[0][s]) &&
+				bounding_box::collides(b.min.y, b.max.y, lo[1][s], hi[1][s]) &&
+				bounding_box::collides(b.min.z, b.max.z, lo[2][s], hi[2][s]))
+				mask |= std::uint64_t(1) << i;
+		}
+		return mask;
+	}
+
+	//bounding_box::intersection(b, box) for every box in [first, first + count), one vector per box split over x, y and z
+	void penetrations(const bounding_box &b, std::size_t first, std::size_t count, float *x, float *y, float *z) const
+	{
+		float *out[3] = {x, y, z};
+		std::size_t i = 0;
+
+#if defined(__AVX2__)
+		const __m256 sign = _mm256_set1_ps(-0.f);
+		__m256 bmin[3];
+		__m256 bmax[3];
+		for (int a = 0; a < 3; ++a)
+		{
+			bmin[a] = _mm256_set1_ps(b.min[a]);
+			bmax[a] = _mm256_set1_ps(b.max[a]);
+		}
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 f[3];
+			for (int a = 0; a < 3; ++a)
+			{
+				__m256 smin = _mm256_loadu_ps(lo[a].data() + first + i);
+				__m256 smax = _mm256_loadu_ps(hi[a].data() + first + i);
+				//bounding_box::overlap
+				f[a] = _mm256_blendv_ps(_mm256_sub_ps(bmax[a], smin), _mm256_sub_ps(bmin[a], smax), _mm256_cmp_ps(bmax[a], smax, _CMP_GT_OQ));
+			}
+
+			//smallest magnitude wins, ties go to the lower axis
+			__m256 best = _mm256_andnot_ps(sign, f[0]);
+			__m256 take_y = _mm256_cmp_ps(_mm256_andnot_ps(sign, f[1]), best, _CMP_LT_OQ);
+			best = _mm256_blendv_ps(best, _mm256_andnot_ps(sign, f[1]), take_y);
+			__m256 take_z = _mm256_cmp_ps(_mm256_andnot_ps(sign, f[2]), best, _CMP_LT_OQ);
+			__m256 take_x = _mm256_andnot_ps(_mm256_or_ps(take_y, take_z), _mm256_castsi256_ps(_mm256_set1_epi32(-1)));
+			take_y = _mm256_andnot_ps(take_z, take_y);
+
+			_mm256_storeu_ps(x + i, _mm256_and_ps(take_x, f[0]));
+			_mm256_storeu_ps(y + i, _mm256_and_ps(take_y, f[1]));
+			_mm256_storeu_ps(z + i, _mm256_and_ps(take_z, f[2]));
+		}
+#elif defined(__SSE2__) || defined(_M_X64)
+		const __m128 sign = _mm_set1_ps(-0.f);
+		__m128 bmin[3];
+		__m128 bmax[3];
+		for (int a = 0; a < 3; ++a)
+		{
+			bmin[a] = _mm_set1_ps(b.min[a]);
+			bmax[a] = _mm_set1_ps(b.max[a]);
+		}
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 f[3];
+			for (int a = 0; a < 3; ++a)
+			{
+				__m128 smin = _mm_loadu_ps(lo[a].data() + first + i);
+				__m128 smax = _mm_loadu_ps(hi[a].data() + first + i);
+				//bounding_box::overlap, sse2 has no blendv
+				__m128 past = _mm_cmpgt_ps(bmax[a], smax);
+				f[a] = _mm_or_ps(_mm_and_ps(past, _mm_sub_ps(bmin[a], smax)), _mm_andnot_ps(past, _mm_sub_ps(bmax[a], smin)));
+			}
+
+			__m128 best = _mm_andnot_ps(sign, f[0]);
+			__m128 take_y = _mm_cmplt_ps(_mm_andnot_ps(sign, f[1]), best);
+			best = _mm_or_ps(_mm_and_ps(take_y, _mm_andnot_ps(sign, f[1])), _mm_andnot_ps(take_y, best));
+			__m128 take_z = _mm_cmplt_ps(_mm_andnot_ps(sign, f[2]), best);
+			__m128 take_x = _mm_andnot_ps(_mm_or_ps(take_y, take_z), _mm_castsi128_ps(_mm_set1_epi32(-1)));
+			take_y = _mm_andnot_ps(take_z, take_y);
+
+			_mm_storeu_ps(x + i, _mm_and_ps(take_x, f[0]));
+			_mm_storeu_ps(y + i, _mm_and_ps(take_y, f[1]));
+			_mm_storeu_ps(z + i, _mm_and_ps(take_z, f[2]));
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			std::size_t s = first + i;
+			float best = INFINITY;
+			int axis = 0;
+			for (int a = 0; a < 3; ++a)
+			{
+				float f = bounding_box::overlap(b.min[a], b.max[a], lo[a][s], hi[a][s]);
+				if (std::abs(f) < std::abs(best))
+				{
+					best = f;
+					axis = a;
+				}
+			}
+
+			for (int a = 0; a < 3; ++a)
+				out[a][i] = a == axis ? best : 0.f;
+		}
+	}
+
+private:
+	std::array<std::vector<float>, 3> lo;
+	std::array<std::vector<float>, 3> hi;
+};
\ No newline at end of file
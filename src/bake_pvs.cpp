@@ -0,0 +1,59 @@
+#include "pvs.h"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+
+//bakepvs maze.png [chunk size] [chunk radius] [block size] [threads]
+//writes maze.png.pvs, chunk size and radius have to match what playmz streams with or it ignores the file
+//argv[i] as a whole number of at least min, or fallback if there is no argv[i], false if it isn't one
+static bool int_arg(int argc, char *argv[], int i, int fallback, int min, int &out)
+{
+	if (argc <= i)
+	{
+		out = fallback;
+		return true;
+	}
+
+	char *end;
+	long v = std::strtol(argv[i], &end, 10);
+	if (end == argv[i] || *end || v < min || v > 1 << 20)
+		return false;
+	out = (int)v;
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *file = argc > 1 ? argv[1] : nullptr;
+	int chunk_size, chunk_radius, block_size, threads;
+
+	//sizes of 0 divide by zero in the bake
+	if (!file || !int_arg(argc, argv, 2, 64, 1, chunk_size) || !int_arg(argc, argv, 3, 2, 0, chunk_radius) ||
+		!int_arg(argc, argv, 4, 8, 1, block_size) || !int_arg(argc, argv, 5, 0, 0, threads))
+	{
+		std::cerr << "usage: " << argv[0] << " maze.png [chunk size = 64] [chunk radius = 2] [block size = 8] [threads = all]\n";
+		std::cerr << "chunk and block size are at least 1, chunk radius and threads at least 0\n";
+		return 1;
+	}
+
+	occupancy_grid maze_grid(file);
+	if (!maze_grid.width())
+	{
+		std::cerr << "couldn't read " << file << "\n";
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	baked_pvs pvs = baked_pvs::bake(maze_grid, chunk_size, chunk_radius, block_size, threads);
+	std::chrono::duration<double> took = std::chrono::steady_clock::now() - start;
+
+	std::string out = std::string(file) + ".pvs";
+	if (!pvs.save(out.c_str()))
+	{
+		std::cerr << "couldn't write " << out << "\n";
+		return 1;
+	}
+
+	std::cout << out << ": " << pvs.block_count() << " blocks, " << pvs.distinct_sets() << " distinct sets, " << took.count() << "s\n";
+}
\ No newline at end of file
@@ -0,0 +1,260 @@
+#pragma once
+#include "object.h"
+#include <map>
+#include <vector>
+#include <cstddef>
+#include <limits>
+#include <iterator>
+#include <algorithm>
+
+//first fit allocator over [0, capacity), only does the bookkeeping
+class range_allocator
+{
+public:
+	static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+	explicit range_allocator(std::size_t capacity = 0) : cap{0}
+	{
+		grow(capacity);
+	}
+
+	//offset of n free elements, or npos
+	std::size_t allocate(std::size_t n)
+	{
+		for (auto it = free.begin(); it != free.end(); ++it)
+		{
+			if (it->second < n)
+				continue;
+
+			std::size_t offset = it->first;
+			std::size_t left = it->second - n;
+			free.erase(it);
+			if (left)
+				free[offset + n] = left;
+			return offset;
+		}
+		return npos;
+	}
+
+	void release(std::size_t offset, std::size_t n)
+	{
+		if (!n)
+			return;
+
+		auto next = free.lower_bound(offset);
+		if (next != free.end() && offset + n == next->first)
+		{
+			n += next->second;
+			next = free.erase(next);
+		}
+
+		if (next != free.begin())
+		{
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset)
+			{
+				prev->second += n;
+				return;
+			}
+		}
+
+		free[offset] = n;
+	}
+
+	void grow(std::size_t new_capacity)
+	{
+		if (new_capacity <= cap)
+			return;
+		release(cap, new_capacity - cap);
+		cap = new_capacity;
+	}
+
+	std::size_t capacity() const
+	{
+		return cap;
+	}
+
+private:
+	std::size_t cap;
+
+	//offset -> length of every free range, neighbours are always merged
+	std::map<std::size_t, std::size_t> free;
+};
+
+//packs many meshes into one interleaved vertex buffer and one index buffer
+//each mesh keeps its own indices (starting at 0) and gets a range of each buffer, all of them are drawn with one glMultiDrawElementsBaseVertex
+class mesh_batch
+{
+public:
+	using handle = std::size_t;
+
+	//every vertex is laid out as format describes, index_type is GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
+	mesh_batch(vertex_format format, GLenum index_type = GL_UNSIGNED_INT, std::size_t vertex_capacity = 1 << 16, std::size_t index_capacity = 1 << 17)
+		: vertex_ranges{vertex_capacity}, index_ranges{index_capacity},
+		  vertices{make_buffer<vbo_target>()}, indices{make_buffer<ebo_target>()},
+		  fmt{std::move(format)}, idx_type{index_type}, idx_size{index_type == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int)}
+	{
+		vertices.reserve_data(vertex_capacity * fmt.stride);
+		indices.reserve_data(index_capacity * idx_size);
+	}
+
+	//vertex_data holds vertex_count vertices of the batch's format, mesh_indices holds index_count indices of its index type
+	//the buffers grow if they are full
+	handle add(const void *vertex_data, std::size_t vertex_count, const void *mesh_indices, std::size_t index_count)
+	{
+		entry e{reserve(vertex_ranges, vertex_count, fmt.stride, vertices), vertex_count,
+				reserve(index_ranges, index_count, idx_size, indices), index_count};
+
+		vertices.attach_sub_data(e.first_vertex * fmt.stride, vertex_count * fmt.stride, vertex_data);
+		indices.attach_sub_data(e.first_index * idx_size, index_count * idx_size, mesh_indices);
+
+		entries[next_handle] = e;
+		dirty = true;
+		return next_handle++;
+	}
+
+	void remove(handle h)
+	{
+		auto it = entries.find(h);
+		if (it == entries.end())
+			return;
+
+		vertex_ranges.release(it->second.first_vertex, it->second.vertex_count);
+		index_ranges.release(it->second.first_index, it->second.index_count);
+		entries.erase(it);
+		dirty = true;
+	}
+
+	//draws every mesh in the batch with one call
+	void draw(GLenum primitive_type) const
+	{
+		if (dirty)
+		{
+			counts.clear();
+			offsets.clear();
+			base_vertices.clear();
+			for (const auto &[h, e] : entries)
+			{
+				counts.push_back((GLsizei)e.index_count);
+				offsets.push_back(reinterpret_cast<const void *>(e.first_index * idx_size));
+				base_vertices.push_back((GLint)e.first_vertex);
+			}
+			dirty = false;
+		}
+
+		submit(primitive_type, counts, offsets, base_vertices);
+	}
+
+	//draws only the meshes of the handles in [first, last) with one call
+	template <typename It>
+	void draw(GLenum primitive_type, It first, It last) const
+	{
+		sub_counts.clear();
+		sub_offsets.clear();
+		sub_base_vertices.clear();
+		for (; first != last; ++first)
+		{
+			auto it = entries.find(*first);
+			if (it == entries.end())
+				continue;
+
+			const entry &e = it->second;
+			sub_counts.push_back((GLsizei)e.index_count);
+			sub_offsets.push_back(reinterpret_cast<const void *>(e.first_index * idx_size));
+			sub_base_vertices.push_back((GLint)e.first_vertex);
+		}
+
+		submit(primitive_type, sub_counts, sub_offsets, sub_base_vertices);
+	}
+
+	std::size_t size() const
+	{
+		return entries.size();
+	}
+
+	std::size_t vertex_capacity() const
+	{
+		return vertex_ranges.capacity();
+	}
+
+	std::size_t index_capacity() const
+	{
+		return index_ranges.capacity();
+	}
+
+	const vertex_format &format() const
+	{
+		return fmt;
+	}
+
+	GLenum index_type() const
+	{
+		return idx_type;
+	}
+
+private:
+	struct entry
+	{
+		std::size_t first_vertex;
+		std::size_t vertex_count;
+		std::size_t first_index;
+		std::size_t index_count;
+	};
+
+	std::map<handle, entry> entries;
+	handle next_handle = 0;
+
+	range_allocator vertex_ranges;
+	range_allocator index_ranges;
+
+	vbo vertices;
+	ebo indices;
+
+	vertex_format fmt;
+	GLenum idx_type;
+	std::size_t idx_size;
+
+	mutable std::vector<GLsizei> counts;
+	mutable std::vector<const void *> offsets;
+	mutable std::vector<GLint> base_vertices;
+	mutable bool dirty = false;
+
+	//rebuilt for every partial draw
+	mutable std::vector<GLsizei> sub_counts;
+	mutable std::vector<const void *> sub_offsets;
+	mutable std::vector<GLint> sub_base_vertices;
+
+	void submit(GLenum primitive_type, const std::vector<GLsizei> &c, const std::vector<const void *> &o, const std::vector<GLint> &b) const
+	{
+		if (c.empty())
+			return;
+
+		vertices.use();
+		fmt.bind();
+		indices.use();
+		glMultiDrawElementsBaseVertex(primitive_type, c.data(), idx_type, o.data(), (GLsizei)c.size(), b.data());
+	}
+
+	//allocates n elements, doubling the capacity of ranges and of buf until they fit
+	template <GLenum t>
+	static std::size_t reserve(range_allocator &ranges, std::size_t n, std::size_t element_bytes, buffer<t> &buf)
+	{
+		std::size_t offset;
+		while ((offset = ranges.allocate(n)) == range_allocator::npos)
+		{
+			std::size_t old_cap = ranges.capacity();
+			std::size_t new_cap = std::max<std::size_t>(old_cap * 2, old_cap + n);
+
+			buffer<t> bigger = make_buffer<t>();
+			bigger.reserve_data(new_cap * element_bytes);
+
+			glBindBuffer(GL_COPY_READ_BUFFER, buf.index());
+			glBindBuffer(GL_COPY_WRITE_BUFFER, bigger.index());
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, old_cap * element_bytes);
+
+			buf = std::move(bigger);
+			ranges.grow(new_cap);
+		}
+		return offset;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,290 @@
+#define GLEW_STATIC
+
+#include "headless.h"
+
+#include "object.h"
+#include "shaders.h"
+
+#include "quad.h"
+
+#include "camera.h"
+
+#include "scene.h"
+#include "visibility.h"
+#include "pvs.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+//camera position and cam.dir() (which points away from where it looks) for one frame
+struct pose
+{
+	glm::vec3 pos;
+	glm::vec3 dir;
+};
+
+//pose looking along yaw (radians from +x towards +z) and pitch (up is positive)
+static pose looking(const glm::vec3 &pos, float yaw, float pitch)
+{
+	return {pos, -glm::vec3(cosf(pitch) * cosf(yaw), sinf(pitch), cosf(pitch) * sinf(yaw))};
+}
+
+//half the frames walk the maze's diagonal at eye height swaying left and right, a quarter turn once around at the centre
+//and the last quarter rise above the walls while tilting down until the whole streamed radius is in view
+static std::vector<pose> scripted_path(int frames, const glm::vec3 &floor_dims)
+{
+	constexpr float eye = 1;
+	constexpr float pi = 3.14159265f;
+
+	glm::vec3 start(floor_dims.x * .1f, eye, floor_dims.z * .1f);
+	glm::vec3 end(floor_dims.x * .9f, eye, floor_dims.z * .9f);
+	glm::vec3 centre(floor_dims.x / 2, eye, floor_dims.z / 2);
+	float diagonal = atan2f(floor_dims.z, floor_dims.x);
+	float top = eye + std::max(floor_dims.x, floor_dims.z) / 4;
+
+	int walk = frames / 2;
+	int turn = frames / 4;
+	int rise = frames - walk - turn;
+
+	std::vector<pose> res;
+	res.reserve(frames);
+	for (int i = 0; i < walk; ++i)
+	{
+		float t = (float)i / std::max(walk - 1, 1);
+		res.push_back(looking(start + (end - start) * t, diagonal + pi / 3 * sinf(4 * pi * t), 0));
+	}
+	for (int i = 0; i < turn; ++i)
+		res.push_back(looking(centre, diagonal + 2 * pi * i / std::max(turn, 1), 0));
+	for (int i = 0; i < rise; ++i)
+	{
+		float t = (float)i / std::max(rise - 1, 1);
+		res.push_back(looking(centre + glm::vec3(0, (top - eye) * t, 0), diagonal, -pi / 3 * t));
+	}
+	return res;
+}
+
+//one "x y z dir_x dir_y dir_z" line per drawn frame, as written by playmz maze.png --record file
+//resampled to frames poses evenly spaced over the recording so any recording can be flown at any length
+static std::vector<pose> recorded_path(const char *file, int frames)
+{
+	std::vector<pose> keys;
+	std::ifstream in(file);
+	std::string line;
+	while (std::getline(in, line))
+	{
+		std::istringstream fields(line);
+		pose p;
+		if (fields >> p.pos.x >> p.pos.y >> p.pos.z >> p.dir.x >> p.dir.y >> p.dir.z && glm::length(p.dir) > 0)
+			keys.push_back(p);
+	}
+
+	std::vector<pose> res;
+	if (keys.empty())
+		return res;
+
+	res.reserve(frames);
+	for (int i = 0; i < frames; ++i)
+	{
+		float t = frames > 1 ? (float)i * (keys.size() - 1) / (frames - 1) : 0;
+		std::size_t k = std::min((std::size_t)t, keys.size() - 1);
+		std::size_t next = std::min(k + 1, keys.size() - 1);
+		float f = t - k;
+
+		pose p{keys[k].pos + (keys[next].pos - keys[k].pos) * f, keys[k].dir + (keys[next].dir - keys[k].dir) * f};
+		if (glm::length(p.dir) == 0)
+			p.dir = keys[k].dir;
+		res.push_back(p);
+	}
+	return res;
+}
+
+static std::string json_string(const std::string &s)
+{
+	std::string res = "\"";
+	for (char c : s)
+	{
+		if (c == '"' || c == '\\')
+			res += '\\';
+		res += c;
+	}
+	return res + "\"";
+}
+
+//min, median, p99 (nearest rank), max and mean of v
+static std::string json_summary(std::vector<double> v)
+{
+	std::sort(v.begin(), v.end());
+
+	auto rank = [&](double p)
+	{
+		std::size_t r = (std::size_t)std::ceil(p * v.size());
+		return v[std::min(std::max(r, (std::size_t)1), v.size()) - 1];
+	};
+
+	double sum = 0;
+	for (double x : v)
+		sum += x;
+
+	std::ostringstream out;
+	out << "{\"min\": " << v.front() << ", \"median\": " << rank(.5) << ", \"p99\": " << rank(.99) << ", \"max\": " << v.back() << ", \"mean\": " << sum / v.size() << "}";
+	return out.str();
+}
+
+//playmz_bench maze.png [frames = 600] [width = 960] [height = 540] [camera path]
+//renders the maze offscreen the way playmz draws it, frame by frame along the camera path, and prints frame times, draw calls and triangles as json
+//without a path file the camera flies a fixed script over the maze, so runs on the same maze are comparable across commits
+//a frame is timed from culling until glFinish returns, chunk streaming is finished before the timer starts so it never lands in a frame
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " maze.png [frames = 600] [width = 960] [height = 540] [camera path]\n";
+		return 1;
+	}
+
+	const char *file = argv[1];
+	int frames = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 600;
+	int width = argc > 3 ? std::atoi(argv[3]) : 960;
+	int height = argc > 4 ? std::atoi(argv[4]) : 540;
+	const char *path_file = argc > 5 ? argv[5] : nullptr;
+
+	//frames drawn along the first pose before timing, the driver compiles shaders and allocates on the first draws
+	constexpr int warmup = 10;
+
+	headless_application app(4, 3);
+	if (!app.valid())
+	{
+		std::cerr << "couldn't make an offscreen opengl 4.3 context\n";
+		return 1;
+	}
+
+	occupancy_grid maze_grid(file);
+	if (!maze_grid.width())
+	{
+		std::cerr << "couldn't read " << file << "\n";
+		return 1;
+	}
+
+	//the settings playmz draws with
+	scene_settings scene;
+	constexpr float mpp = scene_settings::mpp;
+	constexpr int chunk_size = scene_settings::chunk_size;
+	constexpr int chunk_radius = scene_settings::chunk_radius;
+
+	render_target target(width, height, true);
+	if (!target.complete())
+	{
+		std::cerr << "couldn't make a " << width << "x" << height << " render target\n";
+		return 1;
+	}
+
+	vao p_vao;
+	p_vao.use();
+
+	maze_streamer streamer(maze_grid, chunk_size, chunk_radius, scene.wall_cols.data(), scene.wall_model, scene.stream_opts);
+
+	scene_renderer renderer(scene, maze_grid, streamer);
+
+	grid_visibility pvs(maze_grid, chunk_size, chunk_radius);
+
+	baked_pvs baked;
+	std::string baked_file = std::string(file) + ".pvs";
+	bool use_baked = baked.load(baked_file.c_str()) && baked.matches(maze_grid, chunk_size, chunk_radius);
+
+	std::vector<pose> path = path_file ? recorded_path(path_file, frames) : scripted_path(frames, renderer.floor_size());
+	if (path.empty())
+	{
+		std::cerr << "no poses in " << path_file << "\n";
+		return 1;
+	}
+
+	camera cam(0, 0, 0);
+	cam.update_proj_mat(width, height);
+
+	target.bind();
+
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glDepthFunc(GL_LEQUAL);
+	glFrontFace(GL_CCW);
+
+	std::vector<double> frame_ms;
+	std::vector<double> draw_calls;
+	std::vector<double> triangles;
+	std::vector<double> chunks_drawn;
+	double stream_seconds = 0;
+
+	using bench_clock = std::chrono::steady_clock;
+
+	for (int i = -warmup; i < frames; ++i)
+	{
+		const pose &p = path[std::max(i, 0)];
+		cam = p.pos;
+		cam.set_dir(p.dir);
+		cam.update_view_mat();
+
+		glm::vec<2, int> cam_cell{(int)floorf(cam.x / mpp), (int)floorf(cam.z / mpp)};
+
+		auto stream_start = bench_clock::now();
+		streamer.update(cam_cell);
+		streamer.finish();
+		stream_seconds += std::chrono::duration<double>(bench_clock::now() - stream_start).count();
+
+		auto start = bench_clock::now();
+
+		glClearColor(0, 0, 0, 1);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		p_vao.use();
+		renderer.use_walls(cam);
+
+		bool above_walls = cam.y >= scene.wall_size.y;
+
+		baked_pvs::visible_set baked_set = baked.at(cam_cell);
+		if (!above_walls && !use_baked)
+			pvs.update(cam_cell);
+
+		frustum view = cam.view_frustum();
+		streamer.draw_if(GL_TRIANGLES, [&](const maze_streamer::chunk_key &key, const maze_streamer::chunk &c)
+						 { return view.intersects(c.box) && (above_walls || (use_baked ? baked_set.chunk_visible(key) : pvs.chunk_visible(key))); });
+
+		renderer.draw_floor(cam);
+
+		glFinish();
+		double ms = std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+
+		if (i < 0)
+			continue;
+
+		const maze_streamer::draw_stats &drawn = streamer.last_draw();
+		frame_ms.push_back(ms);
+		draw_calls.push_back(drawn.calls + 1.);
+		triangles.push_back((drawn.indices + renderer.floor_indices()) / 3.);
+		chunks_drawn.push_back((double)drawn.chunks);
+	}
+
+	render_target::unbind(width, height);
+
+	std::cout << "{\n"
+			  << "\t\"maze\": " << json_string(file) << ",\n"
+			  << "\t\"maze_size\": [" << maze_grid.width() << ", " << maze_grid.height() << "],\n"
+			  << "\t\"renderer\": " << json_string(reinterpret_cast<const char *>(glGetString(GL_RENDERER))) << ",\n"
+			  << "\t\"gl_version\": " << json_string(reinterpret_cast<const char *>(glGetString(GL_VERSION))) << ",\n"
+			  << "\t\"resolution\": [" << width << ", " << height << "],\n"
+			  << "\t\"path\": " << (path_file ? json_string(path_file) : std::string("\"scripted\"")) << ",\n"
+			  << "\t\"pvs\": " << (use_baked ? "\"baked\"" : "\"rays\"") << ",\n"
+			  << "\t\"frames\": " << frames << ",\n"
+			  << "\t\"frame_ms\": " << json_summary(frame_ms) << ",\n"
+			  << "\t\"draw_calls\": " << json_summary(draw_calls) << ",\n"
+			  << "\t\"triangles\": " << json_summary(triangles) << ",\n"
+			  << "\t\"chunks_drawn\": " << json_summary(chunks_drawn) << ",\n"
+			  << "\t\"stream_seconds\": " << stream_seconds << "\n"
+			  << "}\n";
+}
\ No newline at end of file
@@ -153,43 +153,15 @@ public:
         return max1 - min2;
     }
 
+    //projecting an axis aligned box onto one of the axes gives its min and max on that axis, so no corners are needed
     static glm::vec3 intersection(const bounding_box &a, const bounding_box &b)
     {
         float min_overlap = INFINITY;
-        int min_axis;
-
-        float ap_min;
-        float ap_max;
-        float bp_min;
-        float bp_max;
-
-        float f;
+        int min_axis = 0;
 
         for (int i = 0; i < 3; ++i)
         {
-            //project a and b onto axis, store min and max
-            ap_min = INFINITY;
-            ap_max = -INFINITY;
-            bp_min = INFINITY;
-            bp_max = -INFINITY;
-            for (int c = 0; c < 8; ++c)
-            {
-                f = glm::dot(a[c], axes[i]);
-
-                if (f < ap_min)
-                    ap_min = f;
-                if (f > ap_max)
-                    ap_max = f;
-
-                f = glm::dot(b[c], axes[i]);
-
-                if (f < bp_min)
-                    bp_min = f;
-                if (f > bp_max)
-                    bp_max = f;
-            }
-
-            f = overlap(ap_min, ap_max, bp_min, bp_max);
+            float f = overlap(a.min[i], a.max[i], b.min[i], b.max[i]);
             if (std::abs(f) < std::abs(min_overlap))
             {
                 min_overlap = f;
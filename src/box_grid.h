@@ -0,0 +1,164 @@
+#pragma once
+#include "bounds.h"
+#include "aabb_soa.h"
+#include "occupancy.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+
+//static boxes bucketed into a uniform grid over x and z, a query only visits the cells its box touches
+//every cell keeps a copy of the boxes overlapping it, the copies of all cells sit back to back in one aabb_soa so a cell is tested with the simd kernels
+class box_grid
+{
+public:
+	box_grid() = default;
+
+	//the grid covers the boxes' extent with cells_x * cells_z cells
+	box_grid(std::vector<bounding_box> static_boxes, int cells_x, int cells_z) : boxes(std::move(static_boxes)), nx{std::max(cells_x, 1)}, nz{std::max(cells_z, 1)}
+	{
+		if (boxes.empty())
+			return;
+
+		lo = {boxes[0].min.x, boxes[0].min.z};
+		glm::vec<2, float> hi{boxes[0].max.x, boxes[0].max.z};
+		for (const auto &b : boxes)
+		{
+			lo.x = std::min(lo.x, b.min.x);
+			lo.y = std::min(lo.y, b.min.z);
+			hi.x = std::max(hi.x, b.max.x);
+			hi.y = std::max(hi.y, b.max.z);
+		}
+
+		inv_cell = {nx / std::max(hi.x - lo.x, 1e-6f), nz / std::max(hi.y - lo.y, 1e-6f)};
+
+		//count, prefix sum, then fill
+		first.assign(std::size_t(nx) * nz + 1, 0);
+		for (const auto &b : boxes)
+			for_cells(b, [&](int c)
+					  { ++first[c + 1]; });
+
+		for (std::size_t i = 1; i < first.size(); ++i)
+			first[i] += first[i - 1];
+
+		ids.resize(first.back());
+		std::vector<std::uint32_t> fill(first.begin(), first.end() - 1);
+		for (std::uint32_t i = 0; i < boxes.size(); ++i)
+			for_cells(boxes[i], [&](int c)
+					  { ids[fill[c]++] = i; });
+
+		packed.reserve(ids.size());
+		for (std::uint32_t i : ids)
+			packed.push_back(boxes[i]);
+	}
+
+	//calls f(box) once for every box that collides with b, never allocates
+	template <typename F>
+	void query(const bounding_box &b, F &&f) const
+	{
+		if (boxes.empty())
+			return;
+
+		for_hits(b, [&](std::uint32_t, int, const bounding_box &s)
+				 { f(s); });
+	}
+
+	//sum of bounding_box::intersection(b, box) over every box that collides with b
+	glm::vec3 penetration(const bounding_box &b) const
+	{
+		glm::vec3 res(0, 0, 0);
+		if (boxes.empty())
+			return res;
+
+		float px[64];
+		float py[64];
+		float pz[64];
+		std::uint32_t block = ~std::uint32_t(0);
+
+		for_hits(b, [&](std::uint32_t start, int j, const bounding_box &)
+				 {
+					 //one kernel call per block of 64 copies that has a hit
+					 if (start != block)
+					 {
+						 block = start;
+						 packed.penetrations(b, start, std::min<std::size_t>(64, packed.size() - start), px, py, pz);
+					 }
+					 res += glm::vec3(px[j], py[j], pz[j]); });
+		return res;
+	}
+
+	const std::vector<bounding_box> &all() const
+	{
+		return boxes;
+	}
+
+	std::size_t size() const
+	{
+		return boxes.size();
+	}
+
+	bool empty() const
+	{
+		return boxes.empty();
+	}
+
+private:
+	std::vector<bounding_box> boxes;
+	int nx = 1;
+	int nz = 1;
+
+	glm::vec<2, float> lo{0, 0};
+	glm::vec<2, float> inv_cell{0, 0};
+
+	//boxes of cell c are ids[first[c]] to ids[first[c + 1]], packed holds the same boxes in the same order
+	std::vector<std::uint32_t> first;
+	std::vector<std::uint32_t> ids;
+	aabb_soa packed;
+
+	//calls f(start, j, box) for every box colliding with b, where the box's copy is packed[start + j]
+	//a box spanning several of the visited cells is only reported from the cell holding the corner of the overlap
+	template <typename F>
+	void for_hits(const bounding_box &b, F &&f) const
+	{
+		for_cells(b, [&](int c)
+				  {
+					  int cx = c % nx;
+					  int cz = c / nx;
+					  for (std::uint32_t start = first[c]; start < first[c + 1]; start += 64)
+					  {
+						  std::uint64_t hits = packed.overlap_mask(b, start, std::min<std::uint32_t>(64, first[c + 1] - start));
+						  for (; hits; hits &= hits - 1)
+						  {
+							  int j = bits::ctz(hits);
+							  const bounding_box &s = boxes[ids[start + j]];
+							  if (cell_x(std::max(s.min.x, b.min.x)) == cx && cell_z(std::max(s.min.z, b.min.z)) == cz)
+								  f(start, j, s);
+						  }
+					  } });
+	}
+
+	int cell_x(float x) const
+	{
+		return std::clamp((int)std::floor((x - lo.x) * inv_cell.x), 0, nx - 1);
+	}
+
+	int cell_z(float z) const
+	{
+		return std::clamp((int)std::floor((z - lo.y) * inv_cell.y), 0, nz - 1);
+	}
+
+	//calls f(cell index) for every cell b touches, boxes past the edges touch the edge cells
+	template <typename F>
+	void for_cells(const bounding_box &b, F &&f) const
+	{
+		int x0 = cell_x(b.min.x);
+		int x1 = cell_x(b.max.x);
+		int z0 = cell_z(b.min.z);
+		int z1 = cell_z(b.max.z);
+		for (int z = z0; z <= z1; ++z)
+		{
+			for (int x = x0; x <= x1; ++x)
+				f(z * nx + x);
+		}
+	}
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <GL/glew.h>
 #include <iostream>
+#include <array>
 
 class vao
 {
@@ -62,8 +63,10 @@ public:
 	buffer &operator=(const buffer &) = delete;
 	buffer &operator=(buffer &&other)
 	{
+		glDeleteBuffers(1, &id);
 		id = other.id;
 		other.id = 0;
+		return *this;
 	}
 	void use() const
 	{
@@ -128,6 +131,7 @@ public:
 
 	~buffer()
 	{
+		glDeleteBuffers(1, &id);
 		id = 0;
 	}
 
@@ -151,4 +155,202 @@ buffer<t> make_buffer()
 using vbo = buffer<vbo_target>;
 using ebo = buffer<ebo_target>;
 using ubo = buffer<ubo_target>;
-using ssbo = buffer<ssbo_target>;
\ No newline at end of file
+using ssbo = buffer<ssbo_target>;
+
+//buffer that is written by the cpu every frame, split into regions so the gpu can read one region while the next is written
+//uses a persistently mapped buffer when GL_ARB_buffer_storage is available, otherwise maps each region unsynchronized
+//every frame: ptr = begin(), write at most region_size() bytes to ptr, commit(), draw from region_offset(), fence()
+template <GLenum t, int regions = 3>
+class stream_buffer
+{
+public:
+	explicit stream_buffer(GLsizeiptr region_bytes) : b{make_buffer<t>()}, region_sz{(region_bytes + alignment - 1) / alignment * alignment}, persistent{GLEW_ARB_buffer_storage != 0}
+	{
+		b.use();
+		if (persistent)
+		{
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(t, region_sz * regions, nullptr, flags);
+			mapped = glMapBufferRange(t, 0, region_sz * regions, flags);
+		}
+		else
+			glBufferData(t, region_sz * regions, nullptr, GL_STREAM_DRAW);
+	}
+
+	stream_buffer(const stream_buffer &) = delete;
+	stream_buffer &operator=(const stream_buffer &) = delete;
+
+	~stream_buffer()
+	{
+		for (GLsync f : fences)
+		{
+			if (f)
+				glDeleteSync(f);
+		}
+
+		if (mapped)
+		{
+			b.use();
+			glUnmapBuffer(t);
+		}
+	}
+
+	//moves to the next region, waits until the gpu is done reading it and returns where to write
+	void *begin()
+	{
+		current = (current + 1) % regions;
+
+		GLsync &f = fences[current];
+		if (f)
+		{
+			//only blocks if the cpu is more than regions - 1 frames ahead
+			while (glClientWaitSync(f, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+				;
+			glDeleteSync(f);
+			f = 0;
+		}
+
+		if (persistent)
+			return static_cast<char *>(mapped) + region_offset();
+
+		b.use();
+		return glMapBufferRange(t, region_offset(), region_sz, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	}
+
+	//makes the writes since begin() visible to the gpu
+	void commit() const
+	{
+		if (!persistent)
+		{
+			b.use();
+			glUnmapBuffer(t);
+		}
+	}
+
+	//call after the last draw that reads the current region
+	void fence()
+	{
+		fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	GLintptr region_offset() const
+	{
+		return current * region_sz;
+	}
+
+	GLsizeiptr region_size() const
+	{
+		return region_sz;
+	}
+
+	void use() const
+	{
+		b.use();
+	}
+
+	const buffer<t> &get() const
+	{
+		return b;
+	}
+
+private:
+	//covers GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT on every implementation
+	static constexpr GLsizeiptr alignment = 256;
+
+	buffer<t> b;
+	GLsizeiptr region_sz;
+	bool persistent;
+	void *mapped = nullptr;
+
+	std::array<GLsync, regions> fences{};
+	int current = regions - 1;
+};
+
+//offscreen colour target, drawn into once and copied to the window as often as needed
+class render_target
+{
+public:
+	//with_depth adds a 24 bit depth buffer, only needed to draw 3d into the target
+	render_target(int width, int height, bool with_depth = false) : w{width}, h{height}
+	{
+		glGenTextures(1, &color);
+		glBindTexture(GL_TEXTURE_2D, color);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, w, h);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glGenFramebuffers(1, &fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+
+		if (with_depth)
+		{
+			glGenRenderbuffers(1, &depth);
+			glBindRenderbuffer(GL_RENDERBUFFER, depth);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+			glBindRenderbuffer(GL_RENDERBUFFER, 0);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	render_target(const render_target &) = delete;
+	render_target &operator=(const render_target &) = delete;
+
+	~render_target()
+	{
+		glDeleteFramebuffers(1, &fbo);
+		glDeleteTextures(1, &color);
+		if (depth)
+			glDeleteRenderbuffers(1, &depth);
+	}
+
+	//false if the driver can't render into the target's attachments
+	bool complete() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		bool res = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return res;
+	}
+
+	//everything is drawn into the target until unbind, with a viewport covering it
+	void bind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glViewport(0, 0, w, h);
+	}
+
+	//back to drawing into the window, which is width x height
+	static void unbind(int width, int height)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, width, height);
+	}
+
+	//copies the target into the window with its bottom left corner at x, y
+	void blit(int x, int y) const
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, w, h, x, y, x + w, y + h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	}
+
+	int width() const
+	{
+		return w;
+	}
+
+	int height() const
+	{
+		return h;
+	}
+
+private:
+	GLuint fbo;
+	GLuint color;
+	GLuint depth = 0;
+	int w;
+	int h;
+};
\ No newline at end of file
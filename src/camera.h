@@ -3,6 +3,7 @@
 #include <glm/matrix.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/rotate_vector.hpp>
+#include "frustum.h"
 
 class camera : public glm::vec3
 {
@@ -137,6 +138,12 @@ public:
         return proj;
     }
 
+    //uses the last matrices from update_view_mat and update_proj_mat
+    frustum view_frustum() const
+    {
+        return frustum(proj * view);
+    }
+
 public:
     float clip_near = .1f;
     float clip_far = 1000.f;
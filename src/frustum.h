@@ -0,0 +1,57 @@
+#pragma once
+#include "bounds.h"
+#include <glm/matrix.hpp>
+#include <array>
+
+//the six planes of a view volume, normals point inside
+class frustum
+{
+public:
+    //planes of the clip volume of view_proj (projection * view), in the space view_proj maps from
+    explicit frustum(const glm::mat4 &view_proj)
+    {
+        //glm is column major, row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+        glm::vec4 r[4];
+        for (int i = 0; i < 4; ++i)
+            r[i] = glm::vec4(view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]);
+
+        planes[0] = r[3] + r[0]; //left
+        planes[1] = r[3] - r[0]; //right
+        planes[2] = r[3] + r[1]; //bottom
+        planes[3] = r[3] - r[1]; //top
+        planes[4] = r[3] + r[2]; //near
+        planes[5] = r[3] - r[2]; //far
+
+        for (auto &p : planes)
+            p /= glm::length(glm::vec3(p));
+    }
+
+    //false only if b is completely outside one of the planes, so boxes near the frustum's edges may pass
+    bool intersects(const bounding_box &b) const
+    {
+        for (const auto &p : planes)
+        {
+            //corner of b furthest along the plane's normal
+            glm::vec3 v(p.x >= 0 ? b.max.x : b.min.x,
+                        p.y >= 0 ? b.max.y : b.min.y,
+                        p.z >= 0 ? b.max.z : b.min.z);
+
+            if (glm::dot(glm::vec3(p), v) + p.w < 0)
+                return false;
+        }
+        return true;
+    }
+
+    bool contains(const glm::vec3 &pt) const
+    {
+        for (const auto &p : planes)
+        {
+            if (glm::dot(glm::vec3(p), pt) + p.w < 0)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    std::array<glm::vec4, 6> planes;
+};
\ No newline at end of file
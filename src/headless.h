@@ -0,0 +1,84 @@
+#pragma once
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+
+//an opengl context with no window, made current on the calling thread
+//uses mesa's surfaceless platform when the egl has it so no display server is needed (llvmpipe renders on any box), else the default display
+//there is no default framebuffer, everything has to be drawn into a render_target
+struct headless_application
+{
+	headless_application(int major, int minor)
+	{
+		const char *client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+		auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+		if (get_platform_display && client_extensions && std::strstr(client_extensions, "EGL_MESA_platform_surfaceless"))
+			display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		else
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+		{
+			display = EGL_NO_DISPLAY;
+			return;
+		}
+
+		if (!eglBindAPI(EGL_OPENGL_API))
+			return;
+
+		//the config is only used for the context, no surface is ever made from it
+		const EGLint config_attributes[] = {
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_NONE};
+		EGLConfig config = nullptr;
+		EGLint config_count = 0;
+		if (!eglChooseConfig(display, config_attributes, &config, 1, &config_count) || !config_count)
+			config = nullptr;
+
+		const EGLint context_attributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION_KHR, major,
+			EGL_CONTEXT_MINOR_VERSION_KHR, minor,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+			EGL_NONE};
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+		if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+			return;
+
+		glewExperimental = GL_TRUE;
+
+		//glew looks for a glx display after loading the functions, there is none here
+		GLenum err = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+		if (err == GLEW_ERROR_NO_GLX_DISPLAY)
+			err = GLEW_OK;
+#endif
+		current = err == GLEW_OK;
+	}
+
+	headless_application(const headless_application &) = delete;
+	headless_application &operator=(const headless_application &) = delete;
+
+	~headless_application()
+	{
+		if (display == EGL_NO_DISPLAY)
+			return;
+
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (context != EGL_NO_CONTEXT)
+			eglDestroyContext(display, context);
+		eglTerminate(display);
+	}
+
+	//true if the context was made and gl functions are loaded
+	bool valid() const
+	{
+		return current;
+	}
+
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLContext context = EGL_NO_CONTEXT;
+	bool current = false;
+};
\ No newline at end of file
@@ -1,24 +1,22 @@
 #pragma once
 #include <GLFW/glfw3.h>
-#include <stdexcept>
+#include "spsc_queue.h"
 #include <map>
 #include <functional>
 #include <vector>
+#include <array>
+#include <string>
+#include <cstdint>
 
 class key_handler
 {
 public:
 	static key_handler *get_handler_instance(GLFWwindow *window)
 	{
-		static std::map<GLFWwindow *, key_handler *> instances;
-		try
-		{
-			return instances.at(window);
-		}
-		catch (std::out_of_range)
-		{
-			return instances[window] = new key_handler(window);
-		}
+		auto it = instances().find(window);
+		if (it != instances().end())
+			return it->second;
+		return instances()[window] = new key_handler(window);
 	}
 	key_handler(const key_handler &other) = delete;
 	key_handler(key_handler &&other) = delete;
@@ -26,9 +24,22 @@ public:
 	key_handler &operator=(const key_handler &other) = delete;
 	key_handler &operator=(key_handler &&other) = delete;
 
+	//handles pending events, then starts a new frame of pressed and released flags holding every edge since the last handle()
+	//this is the only place edges change, so call it once per frame
 	static void handle()
 	{
 		glfwPollEvents();
+		next_frame();
+	}
+
+	//sleeps until an event arrives, or for at most timeout seconds if it isn't negative
+	//edges of the events that woke it are kept for the next handle()
+	static void wait(double timeout = -1)
+	{
+		if (timeout < 0)
+			glfwWaitEvents();
+		else
+			glfwWaitEventsTimeout(timeout);
 	}
 
 	static void disable_handler(GLFWwindow *window)
@@ -41,46 +52,90 @@ public:
 		glfwSetKeyCallback(window, callback);
 	}
 
+	//GLFW_PRESS, GLFW_REPEAT or GLFW_RELEASE, keys that were never pressed are released
 	int key_state(int key) const
 	{
-		try
-		{
-			return key_states.at(key);
-		}
-		catch (std::out_of_range)
-		{
-			return GLFW_RELEASE;
-		}
+		return valid(key) ? key_states[key] : GLFW_RELEASE;
+	}
+
+	bool down(int key) const
+	{
+		return key_state(key) != GLFW_RELEASE;
+	}
+
+	//went down between the last two handle() calls
+	bool pressed(int key) const
+	{
+		return valid(key) && edges[key] & pressed_bit;
+	}
+
+	//went up between the last two handle() calls
+	bool released(int key) const
+	{
+		return valid(key) && edges[key] & released_bit;
 	}
 
 private:
-	std::map<int, int> key_states;
+	static constexpr std::uint8_t pressed_bit = 1;
+	static constexpr std::uint8_t released_bit = 2;
+
+	std::array<int, GLFW_KEY_LAST + 1> key_states{};
+	//edges of this frame, and edges of events handled since it started
+	std::array<std::uint8_t, GLFW_KEY_LAST + 1> edges{};
+	std::array<std::uint8_t, GLFW_KEY_LAST + 1> pending{};
 
 	key_handler(GLFWwindow *window)
 	{
 		glfwSetKeyCallback(window, callback);
 	}
 
+	static std::map<GLFWwindow *, key_handler *> &instances()
+	{
+		static std::map<GLFWwindow *, key_handler *> all;
+		return all;
+	}
+
+	static bool valid(int key)
+	{
+		return key >= 0 && key <= GLFW_KEY_LAST;
+	}
+
+	static void next_frame()
+	{
+		for (auto &[window, handler] : instances())
+		{
+			handler->edges = handler->pending;
+			handler->pending.fill(0);
+		}
+	}
+
 	static void callback(GLFWwindow *window, int key, int scancode, int action, int mods)
 	{
-		get_handler_instance(window)->key_states[key] = action;
+		//GLFW_KEY_UNKNOWN
+		if (!valid(key))
+			return;
+
+		key_handler *cur_handler = get_handler_instance(window);
+		cur_handler->key_states[key] = action;
+		if (action == GLFW_PRESS)
+			cur_handler->pending[key] |= pressed_bit;
+		else if (action == GLFW_RELEASE)
+			cur_handler->pending[key] |= released_bit;
 	}
 };
 
+//glfw callbacks only queue events, the registered callbacks run in order when dispatch() drains the queue
+//cursor motion is coalesced, all motion between two flushes becomes one event at the last position, so the callbacks see the summed delta
 class mouse_handler
 {
 public:
 	static mouse_handler *get_handler_instance(GLFWwindow *window)
 	{
 		static std::map<GLFWwindow *, mouse_handler *> instances;
-		try
-		{
-			return instances.at(window);
-		}
-		catch (std::out_of_range)
-		{
-			return instances[window] = new mouse_handler(window);
-		}
+		auto it = instances.find(window);
+		if (it != instances.end())
+			return it->second;
+		return instances[window] = new mouse_handler(window);
 	}
 
 	void add_position_callback(std::function<void(double, double)> new_callback)
@@ -130,14 +185,7 @@ public:
 
 	int button_state(int button) const
 	{
-		try
-		{
-			return button_states.at(button);
-		}
-		catch (std::out_of_range)
-		{
-			return GLFW_RELEASE;
-		}
+		return button >= 0 && button <= GLFW_MOUSE_BUTTON_LAST ? button_states[button] : GLFW_RELEASE;
 	}
 
 	bool is_in_window() const
@@ -145,12 +193,73 @@ public:
 		return in_window;
 	}
 
+	//queues the motion coalesced since the last flush, call after polling on the thread that polls events
+	void flush()
+	{
+		if (!motion_pending)
+			return;
+
+		mouse_event e{mouse_event::motion};
+		e.x = motion_x;
+		e.y = motion_y;
+		if (events.try_push(std::move(e)))
+			motion_pending = false;
+	}
+
+	//runs the callbacks of every queued event in order, once per frame from the thread that reads input
+	void dispatch()
+	{
+		mouse_event e;
+		while (events.try_pop(e))
+		{
+			switch (e.type)
+			{
+			case mouse_event::motion:
+				for (const auto &f : pos_callbacks)
+					f(e.x, e.y);
+				break;
+			case mouse_event::click:
+				for (const auto &f : button_callbacks)
+					f(e.button, e.action, e.mods);
+				break;
+			case mouse_event::enter_exit:
+				for (const auto &f : enter_exit_callbacks)
+					f(e.action);
+				break;
+			}
+		}
+	}
+
 private:
+	struct mouse_event
+	{
+		enum kind
+		{
+			motion,
+			click,
+			enter_exit
+		} type = motion;
+
+		double x = 0;
+		double y = 0;
+		int button = 0;
+		//button action, or entered for enter_exit
+		int action = 0;
+		int mods = 0;
+	};
+
+	//events past the capacity are dropped
+	spsc_queue<mouse_event> events{256};
+
+	bool motion_pending = false;
+	double motion_x = 0;
+	double motion_y = 0;
+
 	std::vector<std::function<void(double, double)>> pos_callbacks;
 	std::vector<std::function<void(int, int, int)>> button_callbacks;
 	std::vector<std::function<void(int)>> enter_exit_callbacks;
 
-	std::map<int, int> button_states;
+	std::array<int, GLFW_MOUSE_BUTTON_LAST + 1> button_states{};
 
 	bool in_window;
 
@@ -163,22 +272,27 @@ private:
 
 	static void pos_callback(GLFWwindow *window, double xpos, double ypos)
 	{
+		mouse_handler *cur_handler = get_handler_instance(window);
 
-		for (const auto &f : get_handler_instance(window)->pos_callbacks)
-		{
-			f(xpos, ypos);
-		}
+		cur_handler->motion_pending = true;
+		cur_handler->motion_x = xpos;
+		cur_handler->motion_y = ypos;
 	}
 	static void button_callback(GLFWwindow *window, int button, int action, int mods)
 	{
 		mouse_handler *cur_handler = get_handler_instance(window);
 
-		cur_handler->button_states[button] = action;
+		if (button >= 0 && button <= GLFW_MOUSE_BUTTON_LAST)
+			cur_handler->button_states[button] = action;
 
-		for (const auto &f : cur_handler->button_callbacks)
-		{
-			f(button, action, mods);
-		}
+		//motion before the click is delivered before it
+		cur_handler->flush();
+
+		mouse_event e{mouse_event::click};
+		e.button = button;
+		e.action = action;
+		e.mods = mods;
+		cur_handler->events.try_push(std::move(e));
 	}
 	static void enter_exit_callback(GLFWwindow *window, int entered)
 	{
@@ -186,10 +300,11 @@ private:
 
 		cur_handler->in_window = entered;
 
-		for (const auto &f : cur_handler->enter_exit_callbacks)
-		{
-			f(entered);
-		}
+		cur_handler->flush();
+
+		mouse_event e{mouse_event::enter_exit};
+		e.action = entered;
+		cur_handler->events.try_push(std::move(e));
 	}
 };
 
@@ -199,14 +314,10 @@ public:
 	static window_size_handler *get_handler_instance(GLFWwindow *window)
 	{
 		static std::map<GLFWwindow *, window_size_handler *> instances;
-		try
-		{
-			return instances.at(window);
-		}
-		catch (std::out_of_range)
-		{
-			return instances[window] = new window_size_handler(window);
-		}
+		auto it = instances.find(window);
+		if (it != instances.end())
+			return it->second;
+		return instances[window] = new window_size_handler(window);
 	}
 
 	void add_callback(std::function<void(int, int)> new_callback)
@@ -258,4 +369,94 @@ private:
 			f(width, height);
 		}
 	}
+};
+
+//named gameplay actions bound to keys, every action is one bit so gameplay tests any set of actions with one mask
+//several keys can be bound to one action, it is held while any of them is down
+class action_map
+{
+public:
+	using mask = std::uint32_t;
+	static constexpr int max_actions = 32;
+
+	//returns the action's bit, binding an existing name adds another key to it
+	//returns 0 and binds nothing once max_actions names are taken
+	mask bind(const std::string &name, int key)
+	{
+		mask bit = action(name);
+		if (!bit)
+		{
+			if (names.size() == max_actions)
+				return 0;
+			bit = mask(1) << names.size();
+			names[name] = bit;
+		}
+
+		bindings.push_back({key, bit});
+		return bit;
+	}
+
+	//0 if nothing was bound to name
+	mask action(const std::string &name) const
+	{
+		auto it = names.find(name);
+		return it == names.end() ? 0 : it->second;
+	}
+
+	//samples every binding, call once after key_handler::handle()
+	void update(const key_handler &keys)
+	{
+		cur = 0;
+		went_down = 0;
+		went_up = 0;
+		for (const auto &b : bindings)
+		{
+			if (keys.down(b.key))
+				cur |= b.bit;
+			if (keys.pressed(b.key))
+				went_down |= b.bit;
+			if (keys.released(b.key))
+				went_up |= b.bit;
+		}
+	}
+
+	mask held() const
+	{
+		return cur;
+	}
+
+	//actions with a bound key that went down or up this frame, a key tapped within one frame is pressed and released but never held
+	mask pressed() const
+	{
+		return went_down;
+	}
+
+	mask released() const
+	{
+		return went_up;
+	}
+
+	bool any_held(mask m) const
+	{
+		return cur & m;
+	}
+
+	bool any_pressed(mask m) const
+	{
+		return pressed() & m;
+	}
+
+private:
+	struct binding
+	{
+		int key;
+		mask bit;
+	};
+
+	std::vector<binding> bindings;
+	std::map<std::string, mask> names;
+
+	mask cur = 0;
+	mask went_down = 0;
+	mask went_up = 0;
 };
\ No newline at end of file
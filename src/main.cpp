@@ -12,15 +12,18 @@
 
 #include "camera.h"
 
-#include "maze.h"
+#include "scene.h"
+#include "maze_cache.h"
+#include "pyramid.h"
+#include "tiles.h"
+#include "visibility.h"
+#include "pvs.h"
+#include "timestep.h"
 
 #include "bounds.h"
 
 #include "texture.h"
 
-#include "shaders/frag.h"
-#include "shaders/vert.h"
-
 #include "minimap/vert.h"
 #include "minimap/frag.h"
 
@@ -29,35 +32,31 @@
 
 #include <iostream>
 #include <fstream>
-
-template <typename It>
-std::vector<It> collides_with(It begin, It end, const bounding_box &box)
-{
-	std::vector<It> collisions;
-	for (auto i = begin; i != end; ++i)
-	{
-		if (bounding_box::collides(*i, box))
-			collisions.push_back(i);
-	}
-	return collisions;
-}
+#include <string>
+#include <thread>
+#include <cmath>
 
 int main(int argc, char *argv[])
 {
 	const char *file = argv[1];
 
-	rgba_image maze(file);
-	std::cout << maze[0][0].col << std::endl;
+	//playmz maze.png --record path.txt writes the camera of every drawn frame, for playmz_bench to fly the same path
+	std::ofstream record;
+	if (argc > 3 && std::string(argv[2]) == "--record")
+		record.open(argv[3]);
 
-	constexpr float mpp = .5;
+	scene_settings scene;
+	constexpr float mpp = scene_settings::mpp;
+	constexpr int chunk_size = scene_settings::chunk_size;
+	constexpr int chunk_radius = scene_settings::chunk_radius;
 
-	std::array<float, 8 * 3> wall_cols;
-	wall_cols.fill(0);
-	for (int i = 0; i < wall_cols.size(); i += 3)
-		wall_cols[i] = 1;
+	//written next to the maze on the first start, later starts map it instead of decoding the png and meshing
+	//keyed by the png's bytes and the settings above, so editing either rebuilds it
+	std::string cache_file = std::string(file) + ".cache";
+	std::uint64_t cache_key = maze_cache::key(file, maze_streamer::settings_hash(chunk_size, scene.wall_cols.data(), scene.wall_model, scene.stream_opts));
+	maze_cache cache;
 
-	std::array<float, 8 * 3> floor_cols;
-	floor_cols.fill(1.0f);
+	occupancy_grid maze_grid = cache.open(cache_file.c_str(), cache_key) ? cache.grid() : occupancy_grid(file);
 
 	constexpr float clip_near = .1;
 	constexpr float clip_far = 1000;
@@ -66,11 +65,20 @@ int main(int argc, char *argv[])
 	glfwSwapInterval(0);
 
 	//minimap setup
-	glm::mat4 ortho_mat = glm::ortho(0.f, (float)app.size_input->width(), (float)app.size_input->height(), 0.f, -1.f, 1.f);
 	model map_model;
 	map_model.scale(glm::vec3(2, 2, 2));
 	glm::ivec2 map_dims{40, 40};
 
+	//the minimap is drawn into its own target only when it changes and copied into the corner of the window every frame
+	//the quad below spans 2 to 2 + map_dims and map_model doubles that, so it covers map_size pixels from map_min (top left)
+	glm::ivec2 map_min{4, 4};
+	glm::ivec2 map_size = 2 * map_dims;
+	render_target map_target(map_size.x, map_size.y);
+	glm::mat4 ortho_mat = glm::ortho((float)map_min.x, (float)(map_min.x + map_size.x), (float)(map_min.y + map_size.y), (float)map_min.y, -1.f, 1.f);
+	bool map_dirty = true;
+	glm::ivec2 map_cell{0, 0};
+	float map_cell_zoom = 0;
+
 	mesh map_mesh({
 					  2.f, 2.f, 0.f,						  //top left corner (0)
 					  2.f + map_dims.x, 2.f, 0.f,			  //top right corner (1)
@@ -85,38 +93,71 @@ int main(int argc, char *argv[])
 
 	float border_color[4] = {220 / 255.f, 220 / 255.f, 220 / 225.f, 1};
 
-	texture maze_txtre(maze, GL_CLAMP_TO_BORDER, border_color);
+	//the minimap shows map_zoom maze cells per map unit, from 1 up to the whole maze, and samples the pyramid level that has about one cell per unit
+	occupancy_pyramid map_levels(maze_grid, std::max(map_dims.x, map_dims.y));
+	constexpr float zoom_speed = 2;
+	float max_zoom = std::max(1.f, (float)std::max(maze_grid.width(), maze_grid.height()) / std::min(map_dims.x, map_dims.y));
+	float map_zoom = 1;
+
+	//only the tiles under the minimap are on the gpu, the minimap is at most 2 * map_dims cells of its level across so 2x2 tiles always cover it
+	occupancy_tiles map_tiles(map_levels);
+	int map_level = 0;
+	glm::ivec2 map_origin{0, 0};
+	std::array<GLint, 4> map_layers;
 
 	uniform ortho = mp.get_uniform("ortho");
 	uniform map_model_uniform = mp.get_uniform("model");
+	uniform map_tile_size = mp.get_uniform("tile_size");
+	uniform map_origin_uniform = mp.get_uniform("origin");
+	uniform map_layers_uniform = mp.get_uniform("layers");
+	uniform map_level_size = mp.get_uniform("level_size");
+	uniform map_border = mp.get_uniform("border");
 
 	vao m_vao;
 	m_vao.use();
 
 	obj map(
 		buffer_data<vbo_target>(map_mesh.vertices().data(), map_mesh.vertices().size() / 3, 3, 0, GL_STATIC_DRAW),
-		buffer_data<vbo_target>(map_txt_coords, 4, 2, 1, GL_STATIC_DRAW),
 		buffer_data<ebo_target>(map_mesh.indices().data(), map_mesh.indices().size(), GL_STATIC_DRAW));
 
+	//texture coordinates are rewritten every frame straight into mapped memory
+	stream_buffer<vbo_target> map_txt_stream(sizeof(map_txt_coords));
+
+	//texture coordinates are in cells of the level being shown
 	auto update_txt_coords = [&](int xcenter, int ycenter)
 	{
+		if (!map_dirty && map_cell == glm::ivec2(xcenter, ycenter) && map_cell_zoom == map_zoom)
+			return;
+		map_cell = {xcenter, ycenter};
+		map_cell_zoom = map_zoom;
+		map_dirty = true;
+
+		map_level = std::clamp((int)std::floor(std::log2(map_zoom)), 0, map_levels.levels() - 1);
+		float scale = 1.f / (1 << map_level);
+
+		float left = (xcenter - map_dims.x / 2.f * map_zoom) * scale;
+		float right = (xcenter + map_dims.x / 2.f * map_zoom) * scale;
+		float top = (ycenter - map_dims.y / 2.f * map_zoom) * scale;
+		float bottom = (ycenter + map_dims.y / 2.f * map_zoom) * scale;
+
 		//top left
-		map_txt_coords[0] = (xcenter - map_dims.x / 2.f) / maze.image_width();
-		map_txt_coords[1] = (ycenter - map_dims.y / 2.f) / maze.image_height();
+		map_txt_coords[0] = left;
+		map_txt_coords[1] = top;
 
 		//top right
-		map_txt_coords[2] = (xcenter + map_dims.x / 2.f) / maze.image_width();
-		map_txt_coords[3] = (ycenter - map_dims.y / 2.f) / maze.image_height();
+		map_txt_coords[2] = right;
+		map_txt_coords[3] = top;
 
 		//bottom left
-		map_txt_coords[4] = (xcenter - map_dims.x / 2.f) / maze.image_width();
-		map_txt_coords[5] = (ycenter + map_dims.y / 2.f) / maze.image_height();
+		map_txt_coords[4] = left;
+		map_txt_coords[5] = bottom;
 
 		//bottom right
-		map_txt_coords[6] = (xcenter + map_dims.x / 2.f) / maze.image_width();
-		map_txt_coords[7] = (ycenter + map_dims.y / 2.f) / maze.image_height();
+		map_txt_coords[6] = right;
+		map_txt_coords[7] = bottom;
 
-		std::get<1>(map).b.attach_sub_data(0, 8 * sizeof(float), map_txt_coords);
+		map_origin = {(int)std::floor(left / occupancy_tiles::tile_size), (int)std::floor(top / occupancy_tiles::tile_size)};
+		map_layers = map_tiles.show(map_level, map_origin);
 	};
 
 	update_txt_coords(0, 0);
@@ -136,49 +177,33 @@ int main(int argc, char *argv[])
 	obj pt(buffer_data<vbo_target>(glm::value_ptr(pt_data), 1, 3, 0, GL_STATIC_DRAW));
 
 	//3d graphics setup
-	program sp = make_program(make_shader(vert_src, GL_VERTEX_SHADER), make_shader(frag_src, GL_FRAGMENT_SHADER));
-
-	uniform mv = sp.get_uniform("mv_mat");
-	uniform proj = sp.get_uniform("proj_mat");
-
 	vao p_vao;
 	p_vao.use();
 
-	maze_loader mz_loader(maze.image_width(), maze.image_height(), maze);
-	mz_loader.load({0, 0});
+	maze_streamer streamer(maze_grid, chunk_size, chunk_radius, scene.wall_cols.data(), scene.wall_model, scene.stream_opts);
 
-	glm::vec3 floor_dims{maze.image_width() * mpp, -1, maze.image_height() * mpp};
+	//a cold start meshes the whole maze for the cache in the background, the streamer keeps meshing its own chunks meanwhile
+	//quitting before it's done cancels it, the next start tries again
+	std::thread cache_writer;
+	std::atomic<bool> cancel_cache{false};
+	//a cache the streamer can't read is a miss like any other, maze_grid is already copied out of it so it's closed and rewritten
+	if (cache.is_open() && !streamer.use_cache(&cache))
+		cache.close();
+	if (!cache.is_open() && cache_key && streamer.cacheable())
+		cache_writer = std::thread([&]()
+								   { streamer.save_cache(cache_file.c_str(), cache_key, &cancel_cache); });
 
-	quad floor_mesh(glm::vec3(0, 0, 0), floor_dims.x, floor_dims.y, floor_dims.z);
+	scene_renderer renderer(scene, maze_grid, streamer);
 
-	glm::vec3 wall_size(mpp, 2, mpp);
-	model wall_model;
-	wall_model.scale(wall_size);
+	bounding_box floor_bounds(glm::vec3(0, 0, 0), renderer.floor_size());
 
-	model floor_model;
+	//chunks the camera's cell can see, walls are scene.wall_size.y high so this only holds while the camera is below their tops
+	grid_visibility pvs(maze_grid, chunk_size, chunk_radius);
 
-	std::vector<obj<buffer_data<vbo_target>, buffer_data<vbo_target>, buffer_data<ebo_target>>> walls;
-	std::vector<bounding_box> wall_bounds;
-	for (const auto &m : mz_loader.meshes())
-	{
-		std::vector<glm::vec3> verts;
-		for (int i = 0; i < m.vertices().size(); i += 3)
-		{
-			verts.emplace_back(glm::vec3(wall_model * glm::vec4{m.vertices()[i], m.vertices()[i + 1], m.vertices()[i + 2], 1}));
-		}
-		wall_bounds.emplace_back(verts);
-		walls.emplace_back(
-			buffer_data<vbo_target>(m.vertices().data(), m.vertices().size() / 3, 3, 0, GL_STATIC_DRAW),
-			buffer_data<vbo_target>(wall_cols.data(), wall_cols.size() / 3, 3, 1, GL_STATIC_DRAW),
-			buffer_data<ebo_target>(m.indices().data(), m.indices().size(), GL_STATIC_DRAW));
-	}
-
-	wall_bounds.emplace_back(glm::vec3(0, 0, 0), floor_dims);
-
-	obj floor(
-		buffer_data<vbo_target>(floor_mesh.vertices().data(), floor_mesh.vertices().size() / 3, 3, 0, GL_STATIC_DRAW),
-		buffer_data<vbo_target>(floor_cols.data(), floor_cols.size() / 3, 3, 1, GL_STATIC_DRAW),
-		buffer_data<ebo_target>(floor_mesh.indices().data(), floor_mesh.indices().size(), GL_STATIC_DRAW));
+	//written by bakepvs next to the maze, replaces the rays with one lookup when it was baked for this maze and chunk settings
+	baked_pvs baked;
+	std::string baked_file = std::string(file) + ".pvs";
+	bool use_baked = baked.load(baked_file.c_str()) && baked.matches(maze_grid, chunk_size, chunk_radius);
 
 	camera cam(-2, 1, -2);
 	cam.look_at(0, 0, 0);
@@ -187,12 +212,32 @@ int main(int argc, char *argv[])
 	constexpr float speed = 3;
 	constexpr float sprint_mult = 2;
 
+	//gameplay reads actions, never raw keys
+	action_map actions;
+	const action_map::mask forward = actions.bind("forward", GLFW_KEY_W);
+	const action_map::mask back = actions.bind("back", GLFW_KEY_S);
+	const action_map::mask left = actions.bind("left", GLFW_KEY_A);
+	const action_map::mask right = actions.bind("right", GLFW_KEY_D);
+	const action_map::mask down = actions.bind("down", GLFW_KEY_LEFT_SHIFT);
+	const action_map::mask up = actions.bind("up", GLFW_KEY_SPACE);
+	const action_map::mask sprint = actions.bind("sprint", GLFW_KEY_R);
+	const action_map::mask pause = actions.bind("pause", GLFW_KEY_ESCAPE);
+	actions.bind("resume", GLFW_KEY_ENTER);
+	const action_map::mask resume = actions.bind("resume", GLFW_KEY_KP_ENTER);
+	const action_map::mask zoom_in = actions.bind("zoom_in", GLFW_KEY_EQUAL);
+	actions.bind("zoom_in", GLFW_KEY_KP_ADD);
+	const action_map::mask zoom_out = actions.bind("zoom_out", GLFW_KEY_MINUS);
+	actions.bind("zoom_out", GLFW_KEY_KP_SUBTRACT);
+	const action_map::mask movement = forward | back | left | right | down | up;
+	const action_map::mask zooming = zoom_in | zoom_out;
+
 	glm::vec3 player_dims(mpp, 1.75, mpp);
 	glm::vec3 cam_player_off(player_dims.x / 2, player_dims.y - mpp, player_dims.z / 2);
 
 	bounding_box player(cam - cam_player_off, player_dims);
 
-	glm::mat4 mv_mat;
+	streamer.update({(int)floorf(cam.x / mpp), (int)floorf(cam.z / mpp)});
+	streamer.finish();
 
 	bool matrix_update_switch = true;
 	glm::vec2 mouse_pos = {app.size_input->width() / 2, app.size_input->height() / 2};
@@ -271,6 +316,11 @@ int main(int argc, char *argv[])
 	app.size_input->add_callback(update_proj_mat);
 	app.size_input->add_callback(update_sensitivity);
 
+	//a frame is only drawn when something on screen changed
+	bool redraw = true;
+	app.size_input->add_callback([&redraw](int, int)
+								 { redraw = true; });
+
 	update_proj_mat(app.size_input->width(), app.size_input->height());
 	update_sensitivity(app.size_input->width(), app.size_input->height());
 	update_viewport(app.size_input->width(), app.size_input->height());
@@ -284,6 +334,16 @@ int main(int argc, char *argv[])
 	float now;
 	float dt;
 
+	//movement and collision run at a fixed rate, the camera is drawn between the eye positions of the last two ticks
+	fixed_timestep sim(120);
+	glm::vec3 prev_eye = cam;
+	glm::vec3 eye = cam;
+
+	//drawn frames are capped at max_fps, with nothing to draw the loop sleeps until an event or at most idle_wait seconds
+	constexpr double max_fps = 240;
+	constexpr double idle_wait = .25;
+	frame_limiter limiter(max_fps);
+
 	while (!glfwWindowShouldClose(app.main_window))
 	{
 		now = glfwGetTime();
@@ -293,24 +353,29 @@ int main(int argc, char *argv[])
 		//std::cout << "\r" << std::fixed << 1 / dt << "fps";
 
 		app.key_input->handle();
+		actions.update(*app.key_input);
+
+		//one camera update for all the cursor motion since last frame
+		app.mouse_input->flush();
+		app.mouse_input->dispatch();
 
-		if (app.key_input->key_state(GLFW_KEY_ESCAPE) == GLFW_PRESS)
+		if (actions.any_held(pause))
 		{
 			app.mouse_input->disable_position_callback(app.main_window);
 			app.mouse_input->disable_enter_exit_callback(app.main_window);
 
 			glfwSetInputMode(app.main_window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-			bool released = false;
 			while (!glfwWindowShouldClose(app.main_window))
 			{
+				app.key_input->wait();
 				app.key_input->handle();
+				actions.update(*app.key_input);
 
-				if (released && app.key_input->key_state(GLFW_KEY_ESCAPE) == GLFW_PRESS)
+				//pausing again quits
+				if (actions.any_pressed(pause))
 					glfwSetWindowShouldClose(app.main_window, GL_TRUE);
-				else if (!released && app.key_input->key_state(GLFW_KEY_ESCAPE) == GLFW_RELEASE)
-					released = true;
 
-				if (app.key_input->key_state(GLFW_KEY_ENTER) || app.key_input->key_state(GLFW_KEY_KP_ENTER))
+				if (actions.any_held(resume))
 				{
 					glfwSetCursorPos(app.main_window, mouse_pos.x, mouse_pos.y);
 					glfwSetInputMode(app.main_window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
@@ -320,113 +385,186 @@ int main(int argc, char *argv[])
 
 			app.mouse_input->enable_position_callback(app.main_window);
 			app.mouse_input->enable_enter_exit_callback(app.main_window);
+
+			//the pause isn't simulated
+			sim.reset();
+			last = glfwGetTime();
 		}
 
-		dcam = {0, 0, 0};
+		float alpha = sim.advance(dt, [&](float step)
+								  {
+									  prev_eye = eye;
 
-		if (app.key_input->key_state(GLFW_KEY_W))
-			dcam -= glm::vec3(cam.dir().x, 0, cam.dir().z);
-		if (app.key_input->key_state(GLFW_KEY_S))
-			dcam += glm::vec3(cam.dir().x, 0, cam.dir().z);
+									  dcam = {0, 0, 0};
 
-		if (app.key_input->key_state(GLFW_KEY_A))
-			dcam -= glm::vec3(cam.right().x, 0, cam.right().z);
-		if (app.key_input->key_state(GLFW_KEY_D))
-			dcam += glm::vec3(cam.right().x, 0, cam.right().z);
+									  if (actions.any_held(forward))
+										  dcam -= glm::vec3(cam.dir().x, 0, cam.dir().z);
+									  if (actions.any_held(back))
+										  dcam += glm::vec3(cam.dir().x, 0, cam.dir().z);
 
-		if (app.key_input->key_state(GLFW_KEY_LEFT_SHIFT))
-			dcam -= cam.up();
-		if (app.key_input->key_state(GLFW_KEY_SPACE))
-			dcam += cam.up();
+									  if (actions.any_held(left))
+										  dcam -= glm::vec3(cam.right().x, 0, cam.right().z);
+									  if (actions.any_held(right))
+										  dcam += glm::vec3(cam.right().x, 0, cam.right().z);
 
-		if (app.key_input->key_state(GLFW_KEY_W) || app.key_input->key_state(GLFW_KEY_A) ||
-			app.key_input->key_state(GLFW_KEY_S) || app.key_input->key_state(GLFW_KEY_D) ||
-			app.key_input->key_state(GLFW_KEY_LEFT_SHIFT) || app.key_input->key_state(GLFW_KEY_SPACE) ||
-			matrix_update_switch)
-		{
-			if (dcam.x || dcam.y || dcam.z)
-			{
-				bounding_box pn = player + dt * speed * (app.key_input->key_state(GLFW_KEY_R) ? sprint_mult : 1) * glm::normalize(dcam);
-				if (auto cs = collides_with(wall_bounds.begin(), wall_bounds.end(), pn); !cs.empty())
-				{
-					glm::vec3 cross{0, 0, 0};
-					glm::vec3 inc;
-					for (auto it : cs)
-					{
-						inc = bounding_box::intersection(pn, *it);
+									  if (actions.any_held(down))
+										  dcam -= cam.up();
+									  if (actions.any_held(up))
+										  dcam += cam.up();
 
-						cross += inc;
-					}
+									  if (!dcam.x && !dcam.y && !dcam.z)
+										  return;
 
-					pn -= cross;
-				}
-				cam = pn.min + cam_player_off;
-				player = pn;
+									  bounding_box pn = player + step * speed * (actions.any_held(sprint) ? sprint_mult : 1) * glm::normalize(dcam);
+									  glm::vec3 cross = streamer.penetration(pn);
+									  if (bounding_box::collides(floor_bounds, pn))
+										  cross += bounding_box::intersection(pn, floor_bounds);
 
+									  pn -= cross;
+
+									  player = pn;
+									  eye = pn.min + cam_player_off; });
+
+		//the minimap zooms at the same rate whatever the frame rate
+		if (actions.any_held(zooming))
+		{
+			float dir = (actions.any_held(zoom_out) ? 1.f : 0.f) - (actions.any_held(zoom_in) ? 1.f : 0.f);
+			float zoom = std::clamp(map_zoom * std::exp2(dir * zoom_speed * dt), 1.f, max_zoom);
+			if (zoom != map_zoom)
+			{
+				map_zoom = zoom;
 				update_txt_coords(cam.x / mpp, cam.z / mpp);
+				redraw = true;
 			}
+		}
+
+		glm::vec3 shown = prev_eye + (eye - prev_eye) * alpha;
+		if (shown != (glm::vec3)cam || matrix_update_switch)
+		{
+			cam = shown;
+
+			update_txt_coords(cam.x / mpp, cam.z / mpp);
+			streamer.update({(int)floorf(cam.x / mpp), (int)floorf(cam.z / mpp)});
+
 			matrix_update_switch = false;
 			cam.update_view_mat();
+			redraw = true;
+		}
+
+		//upload whatever the meshing threads finished since last frame
+		if (streamer.stream())
+			redraw = true;
+
+		if (!redraw)
+		{
+			//held movement or zoom keys and loading chunks need the loop to keep turning, otherwise only an event can change anything
+			if (actions.any_held(movement | zooming) || streamer.loading())
+				app.key_input->wait(std::max(limiter.frame_time(), sim.tick()));
+			else
+			{
+				app.key_input->wait(idle_wait);
+
+				//the idle time isn't simulated
+				sim.reset();
+				last = glfwGetTime();
+			}
+			continue;
 		}
+		redraw = false;
 
 		glClearColor(0, 0, 0, 1);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		//draw walls and floor
-		sp.use();
+		p_vao.use();
+		renderer.use_walls(cam);
 
-		//send uniform variable matrices to shader
-		proj.send<4, 4>(1, GL_FALSE, glm::value_ptr(cam.proj_matrix()));
+		//only chunks inside the view frustum that rays from the camera's cell reach are submitted
+		bool above_walls = cam.y >= scene.wall_size.y;
+		glm::vec<2, int> cam_cell{(int)floorf(cam.x / mpp), (int)floorf(cam.z / mpp)};
 
-		p_vao.use();
+		baked_pvs::visible_set baked_set = baked.at(cam_cell);
+		if (!above_walls && !use_baked)
+			pvs.update(cam_cell);
 
-		mv_mat = cam.view_matrix() * wall_model;
-		mv.send<4, 4>(1, GL_FALSE, glm::value_ptr(mv_mat));
-		for (const auto &wall : walls)
+		frustum view = cam.view_frustum();
+		streamer.draw_if(GL_TRIANGLES, [&](const maze_streamer::chunk_key &key, const maze_streamer::chunk &c)
+						 { return view.intersects(c.box) && (above_walls || (use_baked ? baked_set.chunk_visible(key) : pvs.chunk_visible(key))); });
+
+		renderer.draw_floor(cam);
+
+		//draw mini map, redrawn into its target only when the player's cell or the zoom changed
+		if (map_dirty)
 		{
-			wall.draw(GL_TRIANGLES);
-		}
+			map_target.bind();
+			glClearColor(0, 0, 0, 1);
+			glClear(GL_COLOR_BUFFER_BIT);
 
-		mv_mat = cam.view_matrix() * floor_model;
-		mv.send<4, 4>(1, GL_FALSE, glm::value_ptr(mv_mat));
-		floor.draw(GL_TRIANGLES);
+			//the target has no depth buffer
+			glDisable(GL_DEPTH_TEST);
 
-		//draw mini map
+			mp.use();
 
-		//needed so walls don't clip over map
-		glDisable(GL_DEPTH_TEST);
+			m_vao.use();
 
-		mp.use();
+			ortho.send<4, 4>(1, GL_FALSE, glm::value_ptr(ortho_mat));
+			map_model_uniform.send<4, 4>(1, GL_FALSE, glm::value_ptr((glm::mat4)map_model));
+			map_tile_size.send<GLint>(occupancy_tiles::tile_size);
+			map_origin_uniform.send<GLint>(map_origin.x, map_origin.y);
+			map_layers_uniform.send<1>(4, map_layers.data());
+			map_level_size.send<GLint>(map_levels.level(map_level).width(), map_levels.level(map_level).height());
+			map_border.send<4>(1, border_color);
 
-		m_vao.use();
+			glActiveTexture(GL_TEXTURE0);
+			map_tiles.use();
 
-		ortho.send<4, 4>(1, GL_FALSE, glm::value_ptr(ortho_mat));
-		map_model_uniform.send<4, 4>(1, GL_FALSE, glm::value_ptr((glm::mat4)map_model));
+			float *txt_coords = static_cast<float *>(map_txt_stream.begin());
+			std::copy(map_txt_coords, map_txt_coords + 8, txt_coords);
+			map_txt_stream.commit();
 
-		glActiveTexture(GL_TEXTURE0);
-		maze_txtre.use();
+			map_txt_stream.use();
+			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<const void *>(map_txt_stream.region_offset()));
+			glEnableVertexAttribArray(1);
 
-		map.draw(GL_TRIANGLES);
+			map.draw(GL_TRIANGLES);
+			map_txt_stream.fence();
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 
-		//draw point
-		glPointSize(3);
+			//draw point
+			glPointSize(3);
 
-		pt_p.use();
+			pt_p.use();
 
-		pt_vao.use();
+			pt_vao.use();
 
-		pt_p_ortho.send<4, 4>(1, GL_FALSE, glm::value_ptr(ortho_mat));
-		pt_p_model.send<4, 4>(1, GL_FALSE, glm::value_ptr((glm::mat4)map_model));
-		pt_p_col.send<float>(0.f, 0.f, 204 / 255.f, 1.0);
+			pt_p_ortho.send<4, 4>(1, GL_FALSE, glm::value_ptr(ortho_mat));
+			pt_p_model.send<4, 4>(1, GL_FALSE, glm::value_ptr((glm::mat4)map_model));
+			pt_p_col.send<float>(0.f, 0.f, 204 / 255.f, 1.0);
 
-		pt.draw(GL_POINTS);
+			pt.draw(GL_POINTS);
 
-		glPointSize(1);
-		glEnable(GL_DEPTH_TEST);
+			glPointSize(1);
+			glEnable(GL_DEPTH_TEST);
+
+			render_target::unbind(app.size_input->width(), app.size_input->height());
+			map_dirty = false;
+		}
+
+		//window coordinates start at the bottom
+		map_target.blit(map_min.x, app.size_input->height() - map_min.y - map_size.y);
+
+		if (record.is_open())
+			record << cam.x << " " << cam.y << " " << cam.z << " " << cam.dir().x << " " << cam.dir().y << " " << cam.dir().z << "\n";
 
 		glfwSwapBuffers(app.main_window);
+		limiter.wait();
 	}
 	std::cout << "\n";
+
+	if (cache_writer.joinable())
+	{
+		cancel_cache = true;
+		cache_writer.join();
+	}
 }
\ No newline at end of file
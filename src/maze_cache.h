@@ -0,0 +1,396 @@
+#pragma once
+#include "occupancy.h"
+#include "bounds.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//read only view of a whole file, empty if it couldn't be mapped
+class mapped_file
+{
+public:
+	mapped_file() = default;
+
+	mapped_file(const mapped_file &) = delete;
+	mapped_file &operator=(const mapped_file &) = delete;
+
+	~mapped_file()
+	{
+		close();
+	}
+
+	bool open(const char *file)
+	{
+		close();
+#if defined(_WIN32)
+		HANDLE f = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (f == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER sz;
+		if (GetFileSizeEx(f, &sz) && sz.QuadPart > 0)
+		{
+			HANDLE mapping = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping)
+			{
+				d = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				CloseHandle(mapping);
+				if (d)
+					n = (std::size_t)sz.QuadPart;
+			}
+		}
+		CloseHandle(f);
+#else
+		int fd = ::open(file, O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0)
+		{
+			void *p = mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED)
+			{
+				d = static_cast<const unsigned char *>(p);
+				n = (std::size_t)st.st_size;
+			}
+		}
+		::close(fd);
+#endif
+		return d != nullptr;
+	}
+
+	void close()
+	{
+		if (!d)
+			return;
+#if defined(_WIN32)
+		UnmapViewOfFile(d);
+#else
+		munmap(const_cast<unsigned char *>(d), n);
+#endif
+		d = nullptr;
+		n = 0;
+	}
+
+	const unsigned char *data() const
+	{
+		return d;
+	}
+
+	std::size_t size() const
+	{
+		return n;
+	}
+
+private:
+	const unsigned char *d = nullptr;
+	std::size_t n = 0;
+};
+
+//everything a maze needs before its first frame, written once and memory mapped on every later start
+//the occupancy bits and every chunk's packed vertices, indices and collision boxes, laid out exactly as they are uploaded so nothing is converted on load
+//the file is in the host's byte order, a file from a host of the other order has the wrong magic and is rebuilt like a stale one
+class maze_cache
+{
+public:
+	using chunk_key = std::pair<int, int>;
+
+	//what one chunk lookup returns, pointers into the mapping
+	struct chunk_view
+	{
+		//vertex_count vertices of the cache's vertex stride
+		const void *vertices = nullptr;
+		std::size_t vertex_count = 0;
+		//index_count indices of the cache's index size
+		const void *indices = nullptr;
+		std::size_t index_count = 0;
+		//box_count world space boxes, min then max, 6 floats each
+		const float *boxes = nullptr;
+		std::size_t box_count = 0;
+		bounding_box box{glm::vec3(0, 0, 0), glm::vec3(0, 0, 0)};
+	};
+
+	//fnv-1a over the bytes of file then over settings, 0 if the file can't be read
+	static std::uint64_t key(const char *file, std::uint64_t settings)
+	{
+		FILE *f = fopen(file, "rb");
+		if (!f)
+			return 0;
+
+		std::uint64_t res = fnv_basis;
+		unsigned char buf[1 << 16];
+		std::size_t got;
+		while ((got = fread(buf, 1, sizeof(buf), f)) > 0)
+			res = fnv(res, buf, got);
+		fclose(f);
+
+		return fnv(res, &settings, sizeof(settings));
+	}
+
+	//continues an fnv-1a hash over n bytes, used to hash settings
+	static std::uint64_t fnv(std::uint64_t h, const void *p, std::size_t n)
+	{
+		const unsigned char *b = static_cast<const unsigned char *>(p);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			h ^= b[i];
+			h *= 1099511628211ull;
+		}
+		return h;
+	}
+
+	static constexpr std::uint64_t fnv_basis = 14695981039346656037ull;
+
+	maze_cache() = default;
+
+	//returns false and leaves the cache closed if file is missing, truncated, was written for another key or its grid rows don't match occupancy_grid's
+	bool open(const char *file, std::uint64_t cache_key)
+	{
+		close();
+		if (!cache_key || !f.open(file) || f.size() < sizeof(header))
+			return close();
+
+		std::memcpy(&head, f.data(), sizeof(header));
+		if (head.magic != magic || head.version != version || head.key != cache_key || head.file_size != f.size() ||
+			head.words_per_row != (std::uint32_t)occupancy_grid(head.width, 0).words_per_row())
+			return close();
+
+		std::uint64_t chunks_start = sizeof(header) + std::uint64_t(head.height) * head.words_per_row * sizeof(occupancy_grid::word);
+		std::uint64_t dir_bytes = std::uint64_t(head.chunks_x) * head.chunks_y * sizeof(entry);
+		if (!head.chunk_size || head.chunks_x != (head.width + head.chunk_size - 1) / head.chunk_size || head.chunks_y != (head.height + head.chunk_size - 1) / head.chunk_size ||
+			head.directory % 8 || head.directory < chunks_start || head.directory + dir_bytes != f.size())
+			return close();
+
+		dir = reinterpret_cast<const entry *>(f.data() + head.directory);
+		for (std::size_t i = 0; i < std::size_t(head.chunks_x) * head.chunks_y; ++i)
+		{
+			const entry &e = dir[i];
+			if (e.offset % 8 || e.offset < chunks_start || e.offset + chunk_bytes(e) > head.directory)
+				return close();
+		}
+		return true;
+	}
+
+	bool is_open() const
+	{
+		return dir != nullptr;
+	}
+
+	//unmaps the file so it can be rewritten, always false so open can return close()
+	bool close()
+	{
+		f.close();
+		head = header{};
+		dir = nullptr;
+		return false;
+	}
+
+	int width() const
+	{
+		return head.width;
+	}
+
+	int height() const
+	{
+		return head.height;
+	}
+
+	int chunk_size() const
+	{
+		return head.chunk_size;
+	}
+
+	std::size_t vertex_stride() const
+	{
+		return head.vertex_stride;
+	}
+
+	std::size_t index_size() const
+	{
+		return head.index_size;
+	}
+
+	//copies the occupancy bits out of the mapping
+	occupancy_grid grid() const
+	{
+		occupancy_grid res(head.width, head.height);
+		if (dir)
+			std::memcpy(res.row(0), f.data() + sizeof(header), std::size_t(head.height) * head.words_per_row * sizeof(occupancy_grid::word));
+		return res;
+	}
+
+	//false for chunks outside the maze
+	bool chunk(const chunk_key &k, chunk_view &out) const
+	{
+		if (!dir || k.first < 0 || k.second < 0 || k.first >= (int)head.chunks_x || k.second >= (int)head.chunks_y)
+			return false;
+
+		const entry &e = dir[std::size_t(k.second) * head.chunks_x + k.first];
+		const unsigned char *p = f.data() + e.offset;
+
+		out.vertices = p;
+		out.vertex_count = e.vertex_count;
+		p += pad(std::uint64_t(e.vertex_count) * head.vertex_stride);
+		out.indices = p;
+		out.index_count = e.index_count;
+		p += pad(std::uint64_t(e.index_count) * head.index_size);
+		out.boxes = reinterpret_cast<const float *>(p);
+		out.box_count = e.box_count;
+		out.box = bounding_box(glm::vec3(e.box[0], e.box[1], e.box[2]), glm::vec3(e.box[3] - e.box[0], e.box[4] - e.box[1], e.box[5] - e.box[2]));
+		return true;
+	}
+
+	//writes a cache of grid, get(key, view) has to fill view for every chunk of the grid and may point into memory that only lives until the next call
+	//get returning false gives up, the partial file is deleted and save returns false
+	//the header is written last, so a file cut short by a crash never opens
+	template <typename F>
+	static bool save(const char *file, std::uint64_t cache_key, const occupancy_grid &grid, int chunk_sz, std::size_t vertex_stride, std::size_t index_size, F &&get)
+	{
+		FILE *out = fopen(file, "wb");
+		if (!out)
+			return false;
+
+		header h{};
+		h.version = version;
+		h.key = cache_key;
+		h.width = grid.width();
+		h.height = grid.height();
+		h.words_per_row = grid.words_per_row();
+		h.chunk_size = chunk_sz;
+		h.chunks_x = (grid.width() + chunk_sz - 1) / chunk_sz;
+		h.chunks_y = (grid.height() + chunk_sz - 1) / chunk_sz;
+		h.vertex_stride = (std::uint32_t)vertex_stride;
+		h.index_size = (std::uint32_t)index_size;
+
+		//magic stays 0 until everything else is written
+		fwrite(&h, sizeof(h), 1, out);
+		if (grid.height())
+			fwrite(grid.row(0), sizeof(occupancy_grid::word), std::size_t(grid.height()) * grid.words_per_row(), out);
+
+		std::vector<entry> entries(std::size_t(h.chunks_x) * h.chunks_y);
+		std::uint64_t offset = sizeof(header) + std::uint64_t(grid.height()) * grid.words_per_row() * sizeof(occupancy_grid::word);
+		for (std::uint32_t y = 0; y < h.chunks_y; ++y)
+		{
+			for (std::uint32_t x = 0; x < h.chunks_x; ++x)
+			{
+				chunk_view v;
+				if (!get(chunk_key{(int)x, (int)y}, v))
+				{
+					fclose(out);
+					std::remove(file);
+					return false;
+				}
+
+				entry &e = entries[std::size_t(y) * h.chunks_x + x];
+				e.offset = offset;
+				e.vertex_count = (std::uint32_t)v.vertex_count;
+				e.index_count = (std::uint32_t)v.index_count;
+				e.box_count = (std::uint32_t)v.box_count;
+				for (int a = 0; a < 3; ++a)
+				{
+					e.box[a] = v.box.min[a];
+					e.box[a + 3] = v.box.max[a];
+				}
+
+				write_padded(out, v.vertices, v.vertex_count * vertex_stride);
+				write_padded(out, v.indices, v.index_count * index_size);
+				write_padded(out, v.boxes, v.box_count * 6 * sizeof(float));
+				offset += chunk_bytes(e, vertex_stride, index_size);
+			}
+		}
+
+		h.directory = offset;
+		fwrite(entries.data(), sizeof(entry), entries.size(), out);
+		h.file_size = offset + entries.size() * sizeof(entry);
+
+		h.magic = magic;
+		fseek(out, 0, SEEK_SET);
+		fwrite(&h, sizeof(h), 1, out);
+
+		bool ok = !ferror(out);
+		fclose(out);
+		return ok;
+	}
+
+private:
+	static constexpr std::uint32_t magic = 0x435A4D50; //"PMZC"
+	static constexpr std::uint32_t version = 1;
+
+	struct header
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint64_t key;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t words_per_row;
+		std::uint32_t chunk_size;
+		std::uint32_t chunks_x;
+		std::uint32_t chunks_y;
+		std::uint32_t vertex_stride;
+		std::uint32_t index_size;
+		//byte offset of the chunk directory, after the last chunk and at the end of the file
+		std::uint64_t directory;
+		std::uint64_t file_size;
+	};
+	static_assert(sizeof(header) == 64, "the header is 64 bytes in every build");
+
+	//one per chunk, row major, the chunk's vertices, indices and boxes follow each other from offset, each padded to 8 bytes
+	//chunks sit between the grid and the directory
+	struct entry
+	{
+		std::uint64_t offset;
+		std::uint32_t vertex_count;
+		std::uint32_t index_count;
+		std::uint32_t box_count;
+		//min then max of the chunk's box
+		float box[6];
+		std::uint32_t unused;
+	};
+	static_assert(sizeof(entry) == 48, "entries are 48 bytes in every build");
+
+	mapped_file f;
+	header head{};
+	const entry *dir = nullptr;
+
+	static std::uint64_t pad(std::uint64_t n)
+	{
+		return (n + 7) / 8 * 8;
+	}
+
+	std::uint64_t chunk_bytes(const entry &e) const
+	{
+		return chunk_bytes(e, head.vertex_stride, head.index_size);
+	}
+
+	static std::uint64_t chunk_bytes(const entry &e, std::uint64_t vertex_stride, std::uint64_t index_size)
+	{
+		return pad(e.vertex_count * vertex_stride) + pad(e.index_count * index_size) + pad(std::uint64_t(e.box_count) * 6 * sizeof(float));
+	}
+
+	static void write_padded(FILE *out, const void *p, std::size_t n)
+	{
+		static const unsigned char zeros[8] = {};
+		if (n)
+			fwrite(p, 1, n, out);
+		fwrite(zeros, 1, pad(n) - n, out);
+	}
+};
\ No newline at end of file
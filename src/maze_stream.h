@@ -0,0 +1,676 @@
+#pragma once
+#include "maze.h"
+#include "bounds.h"
+#include "frustum.h"
+#include "box_grid.h"
+#include "worker_pool.h"
+#include "batch.h"
+#include "maze_cache.h"
+#include <map>
+#include <array>
+#include <set>
+#include <deque>
+#include <utility>
+#include <atomic>
+#include <cstdlib>
+
+struct stream_options
+{
+	maze_loader::mode mode = maze_loader::mode::greedy;
+
+	//draw only the faces that can be seen instead of whole boxes
+	bool exposed_faces_only = true;
+
+	//pack every chunk into one shared vertex and index buffer drawn with a single call, instead of one obj per chunk (or per box)
+	bool merged = true;
+
+	//draw every chunk's boxes as instances of one unit box, 24 bytes per wall
+	//overrides exposed_faces_only and merged, needs a shader that reads the instance offset and extent from locations 2 and 3
+	bool instanced = false;
+
+	//walls as 16 bit integer positions (8 bytes per vertex) with the colour from a uniform, instead of float positions and colours (24 bytes)
+	//indices are 16 bit too when a chunk can never need more than 65536 vertices
+	//only used for exposed faces and merged boxes, needs a shader that takes the colour from a uniform, mazes must be smaller than 65536 pixels
+	bool compact = true;
+
+	//0 picks one less than the number of hardware threads
+	unsigned int worker_count = 0;
+};
+
+//splits the maze into chunk_size x chunk_size pixel chunks and keeps only the chunks around the player resident
+//chunks are meshed on worker threads, the render thread only uploads finished meshes
+class maze_streamer
+{
+public:
+	using wall_obj = obj<buffer_data<vbo_target>, buffer_data<vbo_target>, buffer_data<ebo_target>>;
+	//every wall of a chunk in one interleaved buffer
+	using geometry_obj = obj<interleaved_data, buffer_data<ebo_target>>;
+	//unit box positions, unit box colors, per instance offsets and extents, unit box indices
+	using box_instances = obj<buffer_data<vbo_target>, buffer_data<vbo_target>, buffer_data<vbo_target>, buffer_data<vbo_target>, buffer_data<ebo_target>>;
+	using chunk_key = std::pair<int, int>;
+
+	//what the last draw submitted
+	struct draw_stats
+	{
+		std::size_t chunks = 0;
+		std::size_t calls = 0;
+		std::size_t indices = 0;
+	};
+
+	struct chunk
+	{
+		//only used when drawing one obj per box
+		std::vector<wall_obj> walls;
+		//only used when neither merged nor instanced
+		std::vector<geometry_obj> geometry;
+		//only used when instanced
+		std::vector<box_instances> boxes;
+		//only valid when merged and the chunk has geometry
+		mesh_batch::handle batch_id;
+		bool in_batch = false;
+
+		//calls and indices drawing the chunk on its own takes, merged chunks share the batch's one call
+		std::size_t draw_calls = 0;
+		std::size_t index_count = 0;
+
+		//world space collision boxes of the chunk's walls
+		box_grid bounds;
+		//world space box around every wall of the chunk
+		bounding_box box{glm::vec3(0, 0, 0), glm::vec3(0, 0, 0)};
+	};
+
+	//cpu side result of meshing one chunk
+	//boxes is filled when drawing one obj per box, instances when instanced, otherwise vertices and indices hold all of the chunk's walls
+	struct chunk_mesh
+	{
+		chunk_key key;
+		std::vector<quad> boxes;
+		//corner and size of every box, 3 floats each
+		std::vector<float> offsets;
+		std::vector<float> extents;
+		mesh geometry;
+		//geometry packed in the streamer's vertex format, indices are only used when they are 16 bit
+		std::vector<unsigned char> vertices;
+		std::size_t vertex_count = 0;
+		std::vector<unsigned short> short_indices;
+		box_grid bounds;
+		bounding_box box{glm::vec3(0, 0, 0), glm::vec3(0, 0, 0)};
+	};
+
+	//wall_colors holds one rgb color per box vertex (8 * 3 floats)
+	//wall_transform maps loader space (1 unit per pixel) to world space with a scale and translation, it is used to build the collision boxes
+	maze_streamer(const occupancy_grid &maze_grid, int chunk_sz, int chunk_radius, const float *wall_colors, const glm::mat4 &wall_transform, const stream_options &options = {})
+		: inv_transform{glm::inverse(wall_transform)}, loader{chunk_sz, chunk_sz, maze_grid, options.mode}, mz{maze_grid}, size{chunk_sz}, radius{chunk_radius}, opts{options}, cols(wall_colors, wall_colors + 8 * 3), transform{wall_transform}, unit_box{glm::vec3(0, 0, 0), 1, 1, 1},
+		  batch{wall_format(use_compact(options, maze_grid)), use_short_indices(options, maze_grid, chunk_sz) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT},
+		  workers{options.worker_count ? options.worker_count : std::max(2u, std::thread::hardware_concurrency()) - 1, [this](const chunk_key &k)
+				  { return mesh_chunk(k); }}
+	{
+		if (opts.instanced)
+		{
+			opts.exposed_faces_only = false;
+			opts.merged = false;
+		}
+		opts.compact = use_compact(opts, mz);
+		short_indices = use_short_indices(opts, mz, size);
+	}
+
+	//recomputes the wanted chunks around the chunk containing cell and evicts the ones that left the radius
+	//does nothing until cell crosses into another chunk, returns true if the wanted set changed
+	bool update(const glm::vec<2, int> &cell)
+	{
+		chunk_key c = chunk_of(cell);
+		if (has_center && c == center)
+			return false;
+
+		center = c;
+		has_center = true;
+
+		for (auto it = resident.begin(); it != resident.end();)
+		{
+			if (!in_radius(it->first))
+				it = evict(it);
+			else
+				++it;
+		}
+
+		//results for chunks that left the radius are thrown away when they arrive
+		for (auto it = pending.begin(); it != pending.end();)
+		{
+			if (!in_radius(*it))
+				it = pending.erase(it);
+			else
+				++it;
+		}
+
+		queued.clear();
+		for (int y = center.second - radius; y <= center.second + radius; ++y)
+		{
+			for (int x = center.first - radius; x <= center.first + radius; ++x)
+			{
+				if (x < 0 || y < 0 || x * size >= mz.width() || y * size >= mz.height())
+					continue;
+				if (resident.count({x, y}) == 0 && pending.count({x, y}) == 0)
+					queued.push_back({x, y});
+			}
+		}
+
+		//nearest chunks first
+		std::sort(queued.begin(), queued.end(), [this](const chunk_key &a, const chunk_key &b)
+				  { return ring(a) < ring(b); });
+
+		return true;
+	}
+
+	//hands queued chunks to the workers and uploads at most max_uploads finished chunks, never blocks
+	//with a cache queued chunks are uploaded straight from it instead, they count towards max_uploads too
+	//returns true if the resident set changed
+	bool stream(std::size_t max_uploads = 4)
+	{
+		std::size_t uploads = 0;
+		maze_cache::chunk_view view;
+		while (!queued.empty())
+		{
+			chunk_key k = queued.front();
+			if (cache && cache->chunk(k, view))
+			{
+				if (uploads == max_uploads)
+					break;
+				upload(k, view);
+				++uploads;
+			}
+			else if (workers.submit(chunk_key{k}))
+				pending.insert(k);
+			else
+				break;
+			queued.pop_front();
+		}
+
+		workers.drain([&](chunk_mesh &&m)
+					  {
+						  if (pending.erase(m.key))
+						  {
+							  upload(std::move(m));
+							  ++uploads;
+						  } },
+					  max_uploads - uploads);
+		return uploads;
+	}
+
+	//blocks until every wanted chunk is resident, meant for startup and teleports
+	void finish()
+	{
+		while (!queued.empty() || !pending.empty())
+		{
+			if (!stream(std::numeric_limits<std::size_t>::max()))
+				std::this_thread::yield();
+		}
+	}
+
+	//drops every chunk so the next update reloads them
+	void clear()
+	{
+		for (auto it = resident.begin(); it != resident.end();)
+			it = evict(it);
+		pending.clear();
+		queued.clear();
+		has_center = false;
+	}
+
+	void set_radius(int chunk_radius)
+	{
+		radius = chunk_radius;
+		has_center = false;
+	}
+
+	int chunk_radius() const
+	{
+		return radius;
+	}
+
+	int chunk_size() const
+	{
+		return size;
+	}
+
+	const std::map<chunk_key, chunk> &chunks() const
+	{
+		return resident;
+	}
+
+	//draws every resident chunk, one call in total when merged
+	void draw(GLenum primitive_type) const
+	{
+		if (opts.merged)
+		{
+			batch.draw(primitive_type);
+			return;
+		}
+
+		for (const auto &[key, c] : resident)
+			draw_chunk(c, primitive_type);
+	}
+
+	//draws only the resident chunks whose box intersects view, returns how many chunks that was
+	std::size_t draw(GLenum primitive_type, const frustum &view) const
+	{
+		return draw_if(primitive_type, [&view](const chunk_key &, const chunk &c)
+					   { return view.intersects(c.box); });
+	}
+
+	//draws only the resident chunks for which visible(key, chunk) is true, returns how many chunks that was
+	template <typename F>
+	std::size_t draw_if(GLenum primitive_type, F &&visible_fn) const
+	{
+		std::size_t visible = 0;
+		visible_ids.clear();
+		stats = {};
+
+		for (const auto &[key, c] : resident)
+		{
+			if (!visible_fn(key, c))
+				continue;
+			++visible;
+			stats.calls += c.draw_calls;
+			stats.indices += c.index_count;
+
+			if (!opts.merged)
+				draw_chunk(c, primitive_type);
+			else if (c.in_batch)
+				visible_ids.push_back(c.batch_id);
+		}
+
+		if (opts.merged)
+		{
+			batch.draw(primitive_type, visible_ids.begin(), visible_ids.end());
+			stats.calls += !visible_ids.empty();
+		}
+		stats.chunks = visible;
+		return visible;
+	}
+
+	//counts of the last draw_if (or frustum draw), triangles are indices / 3 when drawing GL_TRIANGLES
+	const draw_stats &last_draw() const
+	{
+		return stats;
+	}
+
+	//chunks that are wanted but not uploaded yet
+	std::size_t loading() const
+	{
+		return queued.size() + pending.size();
+	}
+
+	chunk_key chunk_of(const glm::vec<2, int> &cell) const
+	{
+		return {floor_div(cell.x, size), floor_div(cell.y, size)};
+	}
+
+	//calls f(box) once for every collision box of a resident chunk that collides with b, only looks at the chunks b overlaps
+	template <typename F>
+	void query(const bounding_box &b, F &&f) const
+	{
+		for_chunks(b, [&](const chunk &c)
+				   { c.bounds.query(b, f); });
+	}
+
+	//sum of bounding_box::intersection(b, box) over every collision box of a resident chunk that collides with b
+	glm::vec3 penetration(const bounding_box &b) const
+	{
+		glm::vec3 res(0, 0, 0);
+		for_chunks(b, [&](const chunk &c)
+				   { res += c.bounds.penetration(b); });
+		return res;
+	}
+
+	//true if walls use 16 bit positions and take their colour from a uniform
+	bool compact() const
+	{
+		return opts.compact;
+	}
+
+	//true if the chunks can be read from a maze_cache, only walls meshed into one vertex and index buffer per chunk can
+	bool cacheable() const
+	{
+		return !opts.instanced && (opts.exposed_faces_only || opts.merged);
+	}
+
+	//part of a maze_cache key, everything besides the maze that changes what save_cache writes
+	static std::uint64_t settings_hash(int chunk_sz, const float *wall_colors, const glm::mat4 &wall_transform, const stream_options &options)
+	{
+		std::int32_t settings[] = {chunk_sz, (std::int32_t)options.mode, options.exposed_faces_only, options.merged, options.instanced, options.compact};
+
+		std::uint64_t res = maze_cache::fnv(maze_cache::fnv_basis, settings, sizeof(settings));
+		res = maze_cache::fnv(res, wall_colors, 8 * 3 * sizeof(float));
+		return maze_cache::fnv(res, &wall_transform[0][0], 16 * sizeof(float));
+	}
+
+	//reads chunks from c instead of meshing them while c stays set, c has to outlive its use
+	//returns false and keeps meshing if c was written with another layout or chunk size
+	bool use_cache(const maze_cache *c)
+	{
+		cache = nullptr;
+		if (!c || !c->is_open() || !cacheable() || c->chunk_size() != size || c->width() != mz.width() || c->height() != mz.height() ||
+			c->vertex_stride() != batch.format().stride || c->index_size() != index_size())
+			return false;
+
+		cache = c;
+		return true;
+	}
+
+	//meshes every chunk of the maze on the calling thread and writes them to file, false if the streamer isn't cacheable or the file couldn't be written
+	//only reads state that is fixed after construction, so it can run on another thread while the streamer is used
+	//setting cancel stops it before the next chunk and deletes the partial file
+	bool save_cache(const char *file, std::uint64_t cache_key, const std::atomic<bool> *cancel = nullptr) const
+	{
+		if (!cacheable())
+			return false;
+
+		chunk_mesh m;
+		std::vector<float> boxes;
+		return maze_cache::save(file, cache_key, mz, size, batch.format().stride, index_size(), [&](const chunk_key &k, maze_cache::chunk_view &v)
+								{
+									if (cancel && *cancel)
+										return false;
+
+									m = mesh_chunk(k);
+									boxes.clear();
+									for (const auto &b : m.bounds.all())
+										boxes.insert(boxes.end(), {b.min.x, b.min.y, b.min.z, b.max.x, b.max.y, b.max.z});
+
+									v.vertices = m.vertices.data();
+									v.vertex_count = m.vertex_count;
+									v.indices = short_indices ? (const void *)m.short_indices.data() : (const void *)m.geometry.indices().data();
+									v.index_count = m.geometry.indices().size();
+									v.boxes = boxes.data();
+									v.box_count = boxes.size() / 6;
+									v.box = m.box;
+									return true; });
+	}
+
+private:
+	glm::mat4 inv_transform;
+	const maze_loader loader;
+	const occupancy_grid &mz;
+
+	int size;
+	int radius;
+	stream_options opts;
+
+	std::vector<float> cols;
+	glm::mat4 transform;
+	quad unit_box;
+
+	bool short_indices;
+	const maze_cache *cache = nullptr;
+
+	std::map<chunk_key, chunk> resident;
+	mesh_batch batch;
+	mutable std::vector<mesh_batch::handle> visible_ids;
+	mutable draw_stats stats;
+	std::set<chunk_key> pending;
+	std::deque<chunk_key> queued;
+
+	chunk_key center;
+	bool has_center = false;
+
+	//declared last so the threads stop before anything they read is destroyed
+	worker_pool<chunk_key, chunk_mesh> workers;
+
+	//calls f(chunk) for every resident chunk that b, a world space box, overlaps
+	template <typename F>
+	void for_chunks(const bounding_box &b, F &&f) const
+	{
+		glm::vec3 p0 = inv_transform * glm::vec4(b.min, 1);
+		glm::vec3 p1 = inv_transform * glm::vec4(b.max, 1);
+
+		chunk_key lo = chunk_of({(int)std::floor(std::min(p0.x, p1.x)), (int)std::floor(std::min(p0.z, p1.z))});
+		chunk_key hi = chunk_of({(int)std::floor(std::max(p0.x, p1.x)), (int)std::floor(std::max(p0.z, p1.z))});
+
+		for (int y = lo.second; y <= hi.second; ++y)
+		{
+			for (int x = lo.first; x <= hi.first; ++x)
+			{
+				auto it = resident.find({x, y});
+				if (it != resident.end())
+					f(it->second);
+			}
+		}
+	}
+
+	static void draw_chunk(const chunk &c, GLenum primitive_type)
+	{
+		for (const auto &wall : c.walls)
+			wall.draw(primitive_type);
+		for (const auto &g : c.geometry)
+			g.draw(primitive_type);
+		for (const auto &b : c.boxes)
+			b.draw(primitive_type);
+	}
+
+	static bool use_compact(const stream_options &o, const occupancy_grid &g)
+	{
+		return o.compact && !o.instanced && (o.exposed_faces_only || o.merged) && g.width() < 65536 && g.height() < 65536;
+	}
+
+	//a chunk has at most size^2 tops and 2 * size * (size + 1) exposed sides (or size^2 boxes of 8 vertices), 4 vertices per face
+	static bool use_short_indices(const stream_options &o, const occupancy_grid &g, int chunk_sz)
+	{
+		return use_compact(o, g) && 12 * chunk_sz * chunk_sz + 8 * chunk_sz <= 65536;
+	}
+
+	//layout of the vertices in the batch and the per chunk objs
+	static vertex_format wall_format(bool compact)
+	{
+		if (compact)
+			return {{{0, 3, GL_t<GLushort>{}, 0}}, 4 * sizeof(GLushort)};
+		return {{{0, 3, GL_t<GLfloat>{}, 0}, {1, 3, GL_t<GLfloat>{}, 3 * sizeof(GLfloat)}}, 6 * sizeof(GLfloat)};
+	}
+
+	std::size_t index_size() const
+	{
+		return short_indices ? sizeof(unsigned short) : sizeof(unsigned int);
+	}
+
+	//about 4x4 pixels per cell
+	box_grid chunk_bounds(std::vector<bounding_box> walls) const
+	{
+		return box_grid(std::move(walls), std::max(size / 4, 1), std::max(size / 4, 1));
+	}
+
+	static int floor_div(int a, int b)
+	{
+		return a / b - (a % b < 0);
+	}
+
+	int ring(const chunk_key &k) const
+	{
+		return std::max(std::abs(k.first - center.first), std::abs(k.second - center.second));
+	}
+
+	bool in_radius(const chunk_key &k) const
+	{
+		return ring(k) <= radius;
+	}
+
+	std::map<chunk_key, chunk>::iterator evict(std::map<chunk_key, chunk>::iterator it)
+	{
+		if (it->second.in_batch)
+			batch.remove(it->second.batch_id);
+		return resident.erase(it);
+	}
+
+	//runs on a worker thread
+	chunk_mesh mesh_chunk(const chunk_key &k) const
+	{
+		chunk_mesh res;
+		res.key = k;
+
+		glm::vec<2, int> start{k.first * size, k.second * size};
+		glm::vec<2, int> end = start + size;
+
+		bool per_box = !opts.exposed_faces_only && !opts.merged && !opts.instanced;
+		std::vector<bounding_box> walls;
+
+		loader.cover_region(start, end, [&](int x, int y, int width, int length)
+							{
+								std::array<glm::vec3, 2> corners{
+									glm::vec3(transform * glm::vec4(x, 0, y, 1)),
+									glm::vec3(transform * glm::vec4(x + width, 1, y + length, 1))};
+								walls.emplace_back(corners);
+
+								if (opts.exposed_faces_only)
+									return;
+
+								if (opts.instanced)
+								{
+									res.offsets.insert(res.offsets.end(), {(float)x, 0.f, (float)y});
+									res.extents.insert(res.extents.end(), {(float)width, 1.f, (float)length});
+									return;
+								}
+
+								quad box(glm::vec3(x, 0, y), width, 1, length);
+								if (per_box)
+								{
+									res.boxes.push_back(std::move(box));
+									return;
+								}
+
+								unsigned int first = res.geometry.vertices().size() / 3;
+								res.geometry.vertices().insert(res.geometry.vertices().end(), box.vertices().begin(), box.vertices().end());
+								for (unsigned int i : box.indices())
+									res.geometry.indices().push_back(first + i); });
+
+		if (opts.exposed_faces_only)
+			loader.mesh_exposed_faces(start, end, res.geometry);
+
+		if (!walls.empty())
+		{
+			std::vector<glm::vec3> extremes;
+			for (const auto &b : walls)
+			{
+				extremes.push_back(b.min);
+				extremes.push_back(b.max);
+			}
+			res.box = bounding_box(extremes);
+		}
+
+		res.bounds = chunk_bounds(std::move(walls));
+
+		pack(res);
+		return res;
+	}
+
+	//interleaves geometry into the vertex format, runs on a worker thread
+	void pack(chunk_mesh &m) const
+	{
+		const std::vector<float> &v = m.geometry.vertices();
+		m.vertex_count = v.size() / 3;
+
+		if (opts.compact)
+		{
+			std::vector<GLushort> packed(m.vertex_count * 4, 0);
+			for (std::size_t i = 0; i < m.vertex_count; ++i)
+			{
+				for (int j = 0; j < 3; ++j)
+					packed[i * 4 + j] = (GLushort)v[i * 3 + j];
+			}
+
+			const unsigned char *bytes = reinterpret_cast<const unsigned char *>(packed.data());
+			m.vertices.assign(bytes, bytes + packed.size() * sizeof(GLushort));
+		}
+		else
+		{
+			std::vector<GLfloat> packed(m.vertex_count * 6);
+			for (std::size_t i = 0; i < m.vertex_count; ++i)
+			{
+				std::copy(v.begin() + i * 3, v.begin() + i * 3 + 3, packed.begin() + i * 6);
+				std::copy(cols.begin(), cols.begin() + 3, packed.begin() + i * 6 + 3);
+			}
+
+			const unsigned char *bytes = reinterpret_cast<const unsigned char *>(packed.data());
+			m.vertices.assign(bytes, bytes + packed.size() * sizeof(GLfloat));
+		}
+
+		if (short_indices)
+			m.short_indices.assign(m.geometry.indices().begin(), m.geometry.indices().end());
+	}
+
+	void upload(chunk_mesh &&m)
+	{
+		chunk &c = resident[m.key];
+		c.bounds = std::move(m.bounds);
+		c.box = m.box;
+
+		for (const auto &b : m.boxes)
+		{
+			c.walls.emplace_back(
+				buffer_data<vbo_target>(b.vertices().data(), b.vertices().size() / 3, 3, 0, GL_STATIC_DRAW),
+				buffer_data<vbo_target>(cols.data(), cols.size() / 3, 3, 1, GL_STATIC_DRAW),
+				buffer_data<ebo_target>(b.indices().data(), b.indices().size(), GL_STATIC_DRAW));
+			++c.draw_calls;
+			c.index_count += b.indices().size();
+		}
+
+		if (!m.offsets.empty())
+		{
+			c.boxes.emplace_back(
+				buffer_data<vbo_target>(unit_box.vertices().data(), unit_box.vertices().size() / 3, 3, 0, GL_STATIC_DRAW),
+				buffer_data<vbo_target>(cols.data(), cols.size() / 3, 3, 1, GL_STATIC_DRAW),
+				buffer_data<vbo_target>(m.offsets.data(), m.offsets.size() / 3, 3, 2, GL_STATIC_DRAW, 1),
+				buffer_data<vbo_target>(m.extents.data(), m.extents.size() / 3, 3, 3, GL_STATIC_DRAW, 1),
+				buffer_data<ebo_target>(unit_box.indices().data(), unit_box.indices().size(), GL_STATIC_DRAW));
+			++c.draw_calls;
+			c.index_count += unit_box.indices().size() * (m.offsets.size() / 3);
+		}
+
+		const void *indices = short_indices ? (const void *)m.short_indices.data() : (const void *)m.geometry.indices().data();
+		upload_geometry(c, m.vertices.data(), m.vertex_count, indices, m.geometry.indices().size());
+	}
+
+	//uploads a chunk straight from the cache's mapping
+	void upload(const chunk_key &k, const maze_cache::chunk_view &v)
+	{
+		chunk &c = resident[k];
+
+		std::vector<bounding_box> walls;
+		walls.reserve(v.box_count);
+		for (std::size_t i = 0; i < v.box_count; ++i)
+		{
+			const float *b = v.boxes + i * 6;
+			walls.emplace_back(std::array<glm::vec3, 2>{glm::vec3(b[0], b[1], b[2]), glm::vec3(b[3], b[4], b[5])});
+		}
+		c.bounds = chunk_bounds(std::move(walls));
+		c.box = v.box;
+
+		upload_geometry(c, v.vertices, v.vertex_count, v.indices, v.index_count);
+	}
+
+	//vertices are in the batch's format, indices are 16 bit if short_indices
+	void upload_geometry(chunk &c, const void *vertices, std::size_t vertex_count, const void *indices, std::size_t index_count)
+	{
+		if (!index_count)
+			return;
+
+		c.index_count += index_count;
+		if (!opts.merged)
+			++c.draw_calls;
+
+		if (opts.merged)
+		{
+			c.batch_id = batch.add(vertices, vertex_count, indices, index_count);
+			c.in_batch = true;
+		}
+		else if (short_indices)
+		{
+			c.geometry.emplace_back(
+				interleaved_data(vertices, (int)vertex_count, batch.format(), GL_STATIC_DRAW),
+				buffer_data<ebo_target>(static_cast<const unsigned short *>(indices), (int)index_count, GL_STATIC_DRAW));
+		}
+		else
+		{
+			c.geometry.emplace_back(
+				interleaved_data(vertices, (int)vertex_count, batch.format(), GL_STATIC_DRAW),
+				buffer_data<ebo_target>(static_cast<const unsigned int *>(indices), (int)index_count, GL_STATIC_DRAW));
+		}
+	}
+};
\ No newline at end of file
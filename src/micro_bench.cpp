@@ -0,0 +1,331 @@
+#include "image.h"
+#include "occupancy.h"
+#include "maze.h"
+#include "quad.h"
+#include "bounds.h"
+#include "box_grid.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <cstdio>
+
+//every benchmarked call's result is folded in here so none of them can be optimized away
+static volatile std::size_t sink = 0;
+
+struct result
+{
+	std::string name;
+	int size;
+	float density;
+	//median and fastest of the timed batches, per item
+	double ns_per_item;
+	double min_ns_per_item;
+	std::size_t calls_per_batch;
+};
+
+//a batch calls f calls_per_batch times, calls_per_batch doubles until one batch takes at least min_batch_ns, then repeats batches are timed
+//f returns anything convertible to std::size_t and does items operations per call, times are reported per operation
+template <typename F>
+static result measure(const std::string &name, int size, float density, std::size_t items, F &&f)
+{
+	constexpr double min_batch_ns = 25e6;
+	constexpr int repeats = 5;
+
+	using bench_clock = std::chrono::steady_clock;
+	auto batch = [&](std::size_t calls)
+	{
+		auto start = bench_clock::now();
+		for (std::size_t i = 0; i < calls; ++i)
+			sink = sink ^ (std::size_t)f();
+		return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+	};
+
+	std::size_t calls = 1;
+	while (batch(calls) < min_batch_ns && calls < (std::size_t(1) << 30))
+		calls *= 2;
+
+	std::array<double, repeats> times;
+	for (double &t : times)
+		t = batch(calls) / (double(calls) * items);
+	std::sort(times.begin(), times.end());
+
+	return {name, size, density, times[repeats / 2], times.front(), calls};
+}
+
+//a perfect maze with one pixel corridors (about half of it walls) from a depth first search over the odd pixels
+//then random non-post walls are opened, or random open pixels walled, until density of the pixels are walls
+//only std::mt19937's raw output is used, its sequence is fixed by the standard, so every build generates the same mazes
+static occupancy_grid make_maze(int size, float density)
+{
+	std::mt19937 rng(size * 1000 + (unsigned)(density * 100));
+
+	occupancy_grid g(size, size);
+	g.set_rect(0, 0, size, size, true);
+
+	int cells = (size - 1) / 2;
+	std::vector<bool> seen(std::size_t(cells) * cells, false);
+	std::vector<std::pair<int, int>> stack{{0, 0}};
+	seen[0] = true;
+	g.set(1, 1, false);
+
+	const int dx[4] = {1, -1, 0, 0};
+	const int dy[4] = {0, 0, 1, -1};
+	while (!stack.empty())
+	{
+		auto [cx, cy] = stack.back();
+
+		int options[4];
+		int count = 0;
+		for (int d = 0; d < 4; ++d)
+		{
+			int nx = cx + dx[d], ny = cy + dy[d];
+			if (nx >= 0 && ny >= 0 && nx < cells && ny < cells && !seen[std::size_t(ny) * cells + nx])
+				options[count++] = d;
+		}
+
+		if (!count)
+		{
+			stack.pop_back();
+			continue;
+		}
+
+		int d = options[rng() % count];
+		int nx = cx + dx[d], ny = cy + dy[d];
+		seen[std::size_t(ny) * cells + nx] = true;
+		g.set(2 * cx + 1 + dx[d], 2 * cy + 1 + dy[d], false);
+		g.set(2 * nx + 1, 2 * ny + 1, false);
+		stack.push_back({nx, ny});
+	}
+
+	std::size_t target = std::size_t(density * size * size);
+	bool opening = g.count() > target;
+
+	//posts (both coordinates even) and the outer wall are never opened so the maze keeps its shape
+	std::vector<std::pair<int, int>> candidates;
+	for (int y = 1; y < size - 1; ++y)
+	{
+		for (int x = 1; x < size - 1; ++x)
+		{
+			if (g.wall(x, y) == opening && !(opening && x % 2 == 0 && y % 2 == 0))
+				candidates.push_back({x, y});
+		}
+	}
+
+	for (std::size_t i = candidates.size(); i > 1; --i)
+		std::swap(candidates[i - 1], candidates[rng() % i]);
+
+	std::size_t walls = g.count();
+	for (const auto &[x, y] : candidates)
+	{
+		if (walls == target)
+			break;
+		g.set(x, y, !opening);
+		if (opening)
+			--walls;
+		else
+			++walls;
+	}
+
+	return g;
+}
+
+//8 bit grey, walls 0 and open pixels 255
+static bool write_png(const char *file, const occupancy_grid &g)
+{
+	FILE *p = fopen(file, "wb");
+	if (!p)
+		return false;
+
+	png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	png_infop info = png_create_info_struct(png);
+	if (setjmp(png_jmpbuf(png)))
+	{
+		png_destroy_write_struct(&png, &info);
+		fclose(p);
+		return false;
+	}
+
+	png_init_io(png, p);
+	png_set_IHDR(png, info, g.width(), g.height(), 8, PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_write_info(png, info);
+
+	std::vector<png_byte> row(g.width());
+	for (int y = 0; y < g.height(); ++y)
+	{
+		for (int x = 0; x < g.width(); ++x)
+			row[x] = g.wall(x, y) ? 0 : 255;
+		png_write_row(png, row.data());
+	}
+
+	png_write_end(png, info);
+	png_destroy_write_struct(&png, &info);
+	fclose(p);
+	return true;
+}
+
+//microbench [filter]
+//times the loader, mesher and collision paths on generated mazes of every size and wall density below and prints the results as json
+//only cases whose name contains filter are run, nothing here needs a gl context
+//results are comparable across commits built with the same compiler and flags on the same machine, compare ns_per_item
+int main(int argc, char *argv[])
+{
+	std::string filter = argc > 1 ? argv[1] : "";
+
+	const int sizes[] = {128, 512, 2048};
+	const float densities[] = {.3f, .5f, .7f};
+	const int radii[] = {8, 32, 128};
+
+	//streamed chunks are this many pixels across and their collision grids have a cell per 4x4 pixels, as in playmz
+	constexpr int chunk_size = 64;
+
+	//player boxes in loader space (one unit per pixel, walls one unit high), playmz's player is one pixel across and 0.875 walls high
+	constexpr int player_count = 1024;
+	const glm::vec3 player_dims(1, .875f, 1);
+
+	std::vector<result> results;
+	auto run = [&](const std::string &name, int size, float density, std::size_t items, auto &&f)
+	{
+		if (name.find(filter) == std::string::npos)
+			return;
+		std::cerr << name << " " << size << " " << density << "\n";
+		results.push_back(measure(name, size, density, items, f));
+	};
+
+	//doesn't depend on the maze
+	{
+		std::vector<glm::vec3> dims;
+		std::mt19937 rng(1);
+		for (int i = 0; i < 1024; ++i)
+			dims.emplace_back(1 + rng() % 64, 1, 1 + rng() % 64);
+
+		run("quad", 0, 0, dims.size(), [&]()
+			{
+				std::size_t n = 0;
+				for (const auto &d : dims)
+					n += quad(glm::vec3(0, 0, 0), d.x, d.y, d.z).indices().size();
+				return n; });
+	}
+
+	for (int size : sizes)
+	{
+		for (float density : densities)
+		{
+			occupancy_grid maze = make_maze(size, density);
+
+			std::ostringstream png_name;
+			png_name << "playmz_microbench_" << size << "_" << (int)(density * 100) << ".png";
+			std::string png_file = (std::filesystem::temp_directory_path() / png_name.str()).string();
+
+			if (write_png(png_file.c_str(), maze))
+			{
+				run("rgba_image::read_from_file", size, density, 1, [&]()
+					{
+						rgba_image img;
+						img.read_from_file(png_file.c_str());
+						return img.size(); });
+
+				run("occupancy_grid(file)", size, density, 1, [&]()
+					{ return occupancy_grid(png_file.c_str()).count(); });
+
+				std::remove(png_file.c_str());
+			}
+
+			glm::vec<2, int> centre{size / 2, size / 2};
+			for (int r : radii)
+			{
+				maze_loader runs(r, r, maze, maze_loader::mode::runs);
+				run("maze_loader::load/runs/" + std::to_string(r), size, density, 1, [&]()
+					{
+						runs.load(centre);
+						return runs.meshes().size(); });
+
+				maze_loader greedy(r, r, maze, maze_loader::mode::greedy);
+				run("maze_loader::load/greedy/" + std::to_string(r), size, density, 1, [&]()
+					{
+						greedy.load(centre);
+						return greedy.meshes().size(); });
+			}
+
+			//the chunk the player is in
+			glm::vec<2, int> chunk_start = centre / chunk_size * chunk_size;
+			glm::vec<2, int> chunk_end = chunk_start + chunk_size;
+			maze_loader loader(chunk_size, chunk_size, maze, maze_loader::mode::greedy);
+
+			run("maze_loader::mesh_exposed_faces/" + std::to_string(chunk_size), size, density, 1, [&]()
+				{
+					mesh m;
+					loader.mesh_exposed_faces(chunk_start, chunk_end, m);
+					return m.indices().size(); });
+
+			std::vector<bounding_box> walls;
+			loader.cover_region(chunk_start, chunk_end, [&](int x, int y, int width, int length)
+								{ walls.emplace_back(std::array<glm::vec3, 2>{glm::vec3(x, 0, y), glm::vec3(x + width, 1, y + length)}); });
+			if (walls.empty())
+				continue;
+
+			run("box_grid", size, density, 1, [&]()
+				{ return box_grid(walls, chunk_size / 4, chunk_size / 4).size(); });
+
+			std::mt19937 rng(size + 7);
+			std::vector<bounding_box> players;
+			for (int i = 0; i < player_count; ++i)
+			{
+				glm::vec3 p(chunk_start.x + (rng() % (chunk_size * 16)) / 16.f, 0, chunk_start.y + (rng() % (chunk_size * 16)) / 16.f);
+				players.emplace_back(p, player_dims);
+			}
+
+			//players against walls in turn, a wall count that isn't a power of 2 mixes the pairs
+			run("bounding_box::collides", size, density, players.size(), [&]()
+				{
+					std::size_t hits = 0;
+					for (std::size_t i = 0; i < players.size(); ++i)
+						hits += bounding_box::collides(players[i], walls[i % walls.size()]);
+					return hits; });
+
+			run("bounding_box::intersection", size, density, players.size(), [&]()
+				{
+					glm::vec3 sum(0, 0, 0);
+					for (std::size_t i = 0; i < players.size(); ++i)
+						sum += bounding_box::intersection(players[i], walls[i % walls.size()]);
+					return sum.x + sum.y + sum.z; });
+
+			//what collides_with did before the grid, every wall of the chunk tested against the player
+			run("collides_with/linear", size, density, players.size(), [&]()
+				{
+					glm::vec3 sum(0, 0, 0);
+					for (const auto &p : players)
+					{
+						for (const auto &w : walls)
+						{
+							if (bounding_box::collides(p, w))
+								sum += bounding_box::intersection(p, w);
+						}
+					}
+					return sum.x + sum.y + sum.z; });
+
+			box_grid grid(walls, chunk_size / 4, chunk_size / 4);
+			run("box_grid::penetration", size, density, players.size(), [&]()
+				{
+					glm::vec3 sum(0, 0, 0);
+					for (const auto &p : players)
+						sum += grid.penetration(p);
+					return sum.x + sum.y + sum.z; });
+		}
+	}
+
+	std::cout << "[\n";
+	for (std::size_t i = 0; i < results.size(); ++i)
+	{
+		const result &r = results[i];
+		std::cout << "\t{\"name\": \"" << r.name << "\", \"size\": " << r.size << ", \"density\": " << r.density
+				  << ", \"ns_per_item\": " << r.ns_per_item << ", \"min_ns_per_item\": " << r.min_ns_per_item << ", \"calls_per_batch\": " << r.calls_per_batch << "}"
+				  << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	std::cout << "]\n";
+}
\ No newline at end of file
@@ -1,13 +1,39 @@
 const char *map_frag_src = R"(
 #version 430
 
-layout (binding = 0) uniform sampler2D image;
+layout (binding = 0) uniform sampler2DArray tiles;
+
+//tex_coord is in cells of the shown pyramid level, which is level_size cells big
+//the 2x2 tiles from tile origin are in layers (row major), -1 where the level has no tile
+uniform int tile_size;
+uniform ivec2 origin;
+uniform int layers[4];
+uniform ivec2 level_size;
+
+//everything outside the maze
+uniform vec4 border;
 
 in vec2 tex_coord;
 
 out vec4 color;
 
 void main(void){
-    color = texture(image, tex_coord);
+    ivec2 cell = ivec2(floor(tex_coord));
+    ivec2 tile = cell / tile_size - origin;
+    if (any(lessThan(cell, ivec2(0))) || any(greaterThanEqual(cell, level_size)) || any(lessThan(tile, ivec2(0))) || any(greaterThan(tile, ivec2(1))))
+    {
+        color = border;
+        return;
+    }
+
+    int layer = layers[tile.y * 2 + tile.x];
+    if (layer < 0)
+    {
+        color = border;
+        return;
+    }
+
+    float v = texelFetch(tiles, ivec3(cell % tile_size, layer), 0).r;
+    color = vec4(v, v, v, 1);
 }
 )";
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <variant>
 #include <tuple>
+#include <type_traits>
 #include <glm/matrix.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "buffers.h"
@@ -133,14 +134,42 @@ constexpr GLenum type(GL_TYPE_t t)
 	return 0;
 }
 
+//one attribute of an interleaved vertex, offset is in bytes from the start of the vertex
+struct vertex_attrib
+{
+	int loc;
+	int size;
+	GL_TYPE_t type;
+	std::size_t offset;
+	GLboolean normalized = GL_FALSE;
+};
+
+//layout of an interleaved vertex, integer types are converted to float by the shader inputs unless normalized
+struct vertex_format
+{
+	std::vector<vertex_attrib> attribs;
+	int stride;
+
+	void bind(int divisor = 0) const
+	{
+		for (const auto &a : attribs)
+		{
+			glVertexAttribPointer(a.loc, a.size, type(a.type), a.normalized, stride, reinterpret_cast<const void *>(a.offset));
+			glEnableVertexAttribArray(a.loc);
+			glVertexAttribDivisor(a.loc, divisor);
+		}
+	}
+};
+
 template <GLenum t>
 class buffer_data
 {
 public:
 	static constexpr GLenum target = t;
 
+	//a non zero attrib_divisor makes this a per instance attribute that advances once every attrib_divisor instances
 	template <typename T>
-	buffer_data(const T *data, int num_elements, int element_sz, int location, GLenum usage) : b{make_buffer<target>()}, element_size{element_sz}, element_count{num_elements}, loc{location}
+	buffer_data(const T *data, int num_elements, int element_sz, int location, GLenum usage, int attrib_divisor = 0) : b{make_buffer<target>()}, element_size{element_sz}, element_count{num_elements}, loc{location}, divisor{attrib_divisor}
 	{
 		type = GL_t<T>{};
 		b.use();
@@ -152,6 +181,7 @@ public:
 	int element_count;
 	int element_size;
 	int loc;
+	int divisor;
 };
 
 template <>
@@ -173,6 +203,24 @@ public:
 	int element_count;
 };
 
+//vbo holding every attribute of its vertices interleaved as described by format
+class interleaved_data
+{
+public:
+	static constexpr GLenum target = vbo_target;
+
+	interleaved_data(const void *data, int num_vertices, vertex_format vf, GLenum usage, int attrib_divisor = 0) : b{make_buffer<target>()}, format{std::move(vf)}, element_count{num_vertices}, divisor{attrib_divisor}
+	{
+		b.use();
+		b.attach_data((GLsizeiptr)element_count * format.stride, data, usage);
+	}
+
+	buffer<target> b;
+	vertex_format format;
+	int element_count;
+	int divisor;
+};
+
 template <typename... Ts>
 class obj
 {
@@ -181,9 +229,24 @@ public:
 	{
 	}
 
+	//draws instanced if any vbo has a divisor, with as many instances as the instanced vbos have data for
 	void draw(GLenum primitive_type) const
 	{
-		loop_draw(primitive_type, buffs);
+		draw_state s;
+		bind_buffers(s);
+
+		if (s.e)
+		{
+			s.e->b.use();
+			if (s.instance_count >= 0)
+				glDrawElementsInstanced(primitive_type, s.e->element_count, type(s.e->type), 0, s.instance_count);
+			else
+				glDrawElements(primitive_type, s.e->element_count, type(s.e->type), 0);
+		}
+		else if (s.instance_count >= 0)
+			glDrawArraysInstanced(primitive_type, 0, s.vertex_count, s.instance_count);
+		else
+			glDrawArrays(primitive_type, 0, s.vertex_count);
 	}
 
 	const auto &buffers() const
@@ -199,41 +262,58 @@ public:
 private:
 	std::tuple<Ts...> buffs;
 
-	template <int i = 0>
-	static void loop_draw(GLenum primitive_type, const std::tuple<Ts...> &bs)
+	struct draw_state
 	{
-		bool has_ebo = false;
 		const buffer_data<ebo_target> *e = nullptr;
-		int sz;
+		int vertex_count = 0;
+		//-1 when nothing is instanced
+		int instance_count = -1;
+	};
+
+	template <int i = 0>
+	void bind_buffers(draw_state &s) const
+	{
+		using buffer_t = std::tuple_element_t<i, std::tuple<Ts...>>;
+		const buffer_t &b = std::get<i>(buffs);
 
 		//doesn't handle anything besides vbos and ebos so far
-		if constexpr (std::get<i>(bs).target == vbo_target)
+		if constexpr (std::is_same_v<buffer_t, interleaved_data>)
 		{
-			std::get<i>(bs).b.use();
-			glVertexAttribPointer(std::get<i>(bs).loc, std::get<i>(bs).element_size, type(std::get<i>(bs).type), GL_FALSE, 0, 0);
-			glEnableVertexAttribArray(std::get<i>(bs).loc);
-			sz = std::get<i>(bs).element_count;
-		}
-		else if constexpr (std::get<i>(bs).target == ebo_target)
-		{
-			has_ebo = true;
-			e = &std::get<i>(bs);
-		}
+			b.b.use();
+			b.format.bind(b.divisor);
 
-		if constexpr (i + 1 < sizeof...(Ts))
-		{
-			loop_draw<i + 1>(primitive_type, bs);
+			if (b.divisor)
+			{
+				int n = b.element_count * b.divisor;
+				s.instance_count = s.instance_count < 0 ? n : std::min(s.instance_count, n);
+			}
+			else
+				s.vertex_count = b.element_count;
 		}
-		else
+		else if constexpr (buffer_t::target == vbo_target)
 		{
-			if (has_ebo)
+			b.b.use();
+			glVertexAttribPointer(b.loc, b.element_size, type(b.type), GL_FALSE, 0, 0);
+			glEnableVertexAttribArray(b.loc);
+
+			//always set, the vao may have been left with a divisor by another obj
+			glVertexAttribDivisor(b.loc, b.divisor);
+
+			if (b.divisor)
 			{
-				std::get<i>(bs).b.use();
-				glDrawElements(primitive_type, e->element_count, type(e->type), 0);
+				int n = b.element_count * b.divisor;
+				s.instance_count = s.instance_count < 0 ? n : std::min(s.instance_count, n);
 			}
 			else
-				glDrawArrays(primitive_type, 0, sz);
+				s.vertex_count = b.element_count;
+		}
+		else if constexpr (buffer_t::target == ebo_target)
+		{
+			s.e = &b;
 		}
+
+		if constexpr (i + 1 < sizeof...(Ts))
+			bind_buffers<i + 1>(s);
 	}
 };
 
@@ -0,0 +1,465 @@
+#pragma once
+#include "image.h"
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace bits
+{
+	//index of the lowest set bit, v must not be 0
+	inline int ctz(std::uint64_t v)
+	{
+#if defined(_MSC_VER)
+		unsigned long i;
+		_BitScanForward64(&i, v);
+		return (int)i;
+#else
+		return __builtin_ctzll(v);
+#endif
+	}
+
+	//number of zero bits above the highest set bit, v must not be 0
+	inline int clz(std::uint64_t v)
+	{
+#if defined(_MSC_VER)
+		unsigned long i;
+		_BitScanReverse64(&i, v);
+		return 63 - (int)i;
+#else
+		return __builtin_clzll(v);
+#endif
+	}
+
+	inline int popcount(std::uint64_t v)
+	{
+#if defined(_MSC_VER)
+		return (int)__popcnt64(v);
+#else
+		return __builtin_popcountll(v);
+#endif
+	}
+
+	//bits [from, 64) set, from may be 64
+	inline std::uint64_t from(int from)
+	{
+		return from >= 64 ? 0 : ~std::uint64_t(0) << from;
+	}
+
+	//bits [from, to) set, 0 <= from <= to <= 64
+	inline std::uint64_t range(int from, int to)
+	{
+		return bits::from(from) & ~bits::from(to);
+	}
+}
+
+//one bit per maze pixel, set where the pixel is a wall
+//rows are padded to a multiple of 4 words so kernels can always read 256 bits at a time
+class occupancy_grid
+{
+public:
+	using word = std::uint64_t;
+	static constexpr int word_bits = 64;
+
+	occupancy_grid() : w{0}, h{0}, stride{0} {}
+
+	//all cells open
+	occupancy_grid(int width, int height) : w{width}, h{height}, stride{(width + 255) / 256 * 4}, d(std::size_t(stride) * height, 0)
+	{
+	}
+
+	//black pixels (red channel 0) are walls
+	explicit occupancy_grid(const rgba_image &img) : occupancy_grid((int)img.image_width(), (int)img.image_height())
+	{
+		int bpp = img.bytes_per_pixel();
+		for (int y = 0; y < h; ++y)
+		{
+			const rgba_image::color *src = img[y];
+			word *dst = row(y);
+			for (int x = 0; x < w; ++x)
+			{
+				if (!src[x * bpp].col)
+					dst[x / word_bits] |= word(1) << (x % word_bits);
+			}
+		}
+	}
+
+	//reads the png one row at a time and thresholds each row straight into the grid, only one row of pixels is ever held
+	//same rule as above, a pixel is a wall if its red (or grey) channel is 0, an unreadable file gives an empty grid
+	explicit occupancy_grid(const char *file) : occupancy_grid()
+	{
+		FILE *p = fopen(file, "rb");
+		if (!p)
+			return;
+
+		png_struct *png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+		png_info *info = png ? png_create_info_struct(png) : nullptr;
+		if (!info)
+		{
+			png_destroy_read_struct(&png, nullptr, nullptr);
+			fclose(p);
+			return;
+		}
+
+		//declared before the setjmp so a longjmp out of libpng never skips its destructor
+		std::vector<png_byte> src;
+
+		//libpng jumps back here on a corrupt or truncated file, the grid is left empty
+		if (setjmp(png_jmpbuf(png)))
+		{
+			png_destroy_read_struct(&png, &info, nullptr);
+			fclose(p);
+			*this = occupancy_grid();
+			return;
+		}
+
+		png_init_io(png, p);
+
+		png_read_info(png, info);
+
+		png_uint_32 width, height;
+		int depth, color_type;
+		png_get_IHDR(png, info, &width, &height, &depth, &color_type, nullptr, nullptr, nullptr);
+
+		//8 bits per channel with red (or grey) first, but no channels added
+		if (depth == 16)
+			png_set_strip_16(png);
+		if (color_type == PNG_COLOR_TYPE_PALETTE)
+			png_set_palette_to_rgb(png);
+		if (color_type == PNG_COLOR_TYPE_GRAY && depth < 8)
+			png_set_expand_gray_1_2_4_to_8(png);
+		int passes = png_set_interlace_handling(png);
+
+		png_read_update_info(png, info);
+
+		*this = occupancy_grid((int)width, (int)height);
+		int channels = png_get_channels(png, info);
+		src.resize(png_get_rowbytes(png, info));
+
+		for (int pass = 0; pass < passes; ++pass)
+		{
+			for (int y = 0; y < h; ++y)
+			{
+				//an interlaced pass only writes its own pixels into the row, the others stay open, every pixel is in exactly one pass
+				std::fill(src.begin(), src.end(), png_byte(0xFF));
+				png_read_row(png, src.data(), nullptr);
+
+				word *dst = row(y);
+				for (int wi = 0; wi * word_bits < w; ++wi)
+				{
+					const png_byte *px = src.data() + std::size_t(wi) * word_bits * channels;
+					int n = std::min(word_bits, w - wi * word_bits);
+
+					word walls = 0;
+					for (int b = 0; b < n; ++b)
+						walls |= word(!px[b * channels]) << b;
+					dst[wi] |= walls;
+				}
+			}
+		}
+
+		png_read_end(png, info);
+		png_destroy_read_struct(&png, &info, nullptr);
+		fclose(p);
+	}
+
+	int width() const
+	{
+		return w;
+	}
+
+	int height() const
+	{
+		return h;
+	}
+
+	int words_per_row() const
+	{
+		return stride;
+	}
+
+	const word *row(int y) const
+	{
+		return d.data() + std::size_t(y) * stride;
+	}
+
+	word *row(int y)
+	{
+		return d.data() + std::size_t(y) * stride;
+	}
+
+	//the 64 cells of row y starting at x as one word, x may be negative, cells outside the grid are open
+	word bits_at(int y, int x) const
+	{
+		if (y < 0 || y >= h)
+			return 0;
+
+		int wi = x >= 0 ? x / word_bits : -((word_bits - 1 - x) / word_bits);
+		int off = x - wi * word_bits;
+
+		const word *r = row(y);
+		word lo = wi >= 0 && wi < stride ? r[wi] : 0;
+		if (!off)
+			return lo;
+
+		word hi = wi + 1 >= 0 && wi + 1 < stride ? r[wi + 1] : 0;
+		return lo >> off | hi << (word_bits - off);
+	}
+
+	//cells outside the grid are open
+	bool wall(int x, int y) const
+	{
+		if (x < 0 || y < 0 || x >= w || y >= h)
+			return false;
+		return row(y)[x / word_bits] >> (x % word_bits) & 1;
+	}
+
+	void set(int x, int y, bool is_wall)
+	{
+		word bit = word(1) << (x % word_bits);
+		if (is_wall)
+			row(y)[x / word_bits] |= bit;
+		else
+			row(y)[x / word_bits] &= ~bit;
+	}
+
+	//sets cells [x0, x1) of row y
+	void set_range(int y, int x0, int x1, bool is_wall)
+	{
+		for_each_word(x0, x1, [&](int wi, word mask)
+					  {
+						  if (is_wall)
+							  row(y)[wi] |= mask;
+						  else
+							  row(y)[wi] &= ~mask; });
+	}
+
+	void set_rect(int x, int y, int width, int height, bool is_wall)
+	{
+		for (int j = y; j < y + height; ++j)
+			set_range(j, x, x + width, is_wall);
+	}
+
+	//true if every cell in [x0, x1) of row y is a wall
+	bool all(int y, int x0, int x1) const
+	{
+		bool res = true;
+		for_each_word(x0, x1, [&](int wi, word mask)
+					  { res = res && (row(y)[wi] & mask) == mask; });
+		return res;
+	}
+
+	//first wall at or after x in row y, or -1
+	int find_next(int y, int x) const
+	{
+		if (x >= w)
+			return -1;
+
+		const word *r = row(y);
+		int wi = x / word_bits;
+		word cur = r[wi] & bits::from(x % word_bits);
+
+		int last = (w - 1) / word_bits;
+		while (!cur && wi < last)
+			cur = r[++wi];
+
+		if (!cur)
+			return -1;
+		int res = wi * word_bits + bits::ctz(cur);
+		return res < w ? res : -1;
+	}
+
+	//number of consecutive walls in row y starting at x
+	int run_length(int y, int x) const
+	{
+		const word *r = row(y);
+		int wi = x / word_bits;
+		int start = x;
+
+		word gaps = ~r[wi] & bits::from(x % word_bits);
+		int last = (w - 1) / word_bits;
+		while (!gaps && wi < last)
+			gaps = ~r[++wi];
+
+		int end = gaps ? wi * word_bits + bits::ctz(gaps) : w;
+		return std::min(end, w) - start;
+	}
+
+	std::size_t count() const
+	{
+		std::size_t c = 0;
+		for (word v : d)
+			c += bits::popcount(v);
+		return c;
+	}
+
+	//calls f(x, length) for every maximal run of walls in [x0, x1) of row y, left to right
+	template <typename F>
+	void horizontal_runs(int y, int x0, int x1, F &&f) const
+	{
+		x0 = std::max(x0, 0);
+		x1 = std::min(x1, w);
+		if (x1 <= x0)
+			return;
+
+		const word *r = row(y);
+		int first = x0 / word_bits;
+		int last = (x1 - 1) / word_bits;
+
+		bool in_run = false;
+		int run_start = 0;
+
+		for (int wi = first; wi <= last; ++wi)
+		{
+#if defined(__AVX2__)
+			//outside a run, skip 256 empty cells at a time
+			if (!in_run && wi % 4 == 0 && wi + 3 < last)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r + wi));
+				if (_mm256_testz_si256(v, v))
+				{
+					wi += 3;
+					continue;
+				}
+			}
+#endif
+			int base = wi * word_bits;
+			word cur = r[wi] & bits::range(wi == first ? x0 - base : 0, wi == last ? x1 - base : word_bits);
+
+			int offset = 0;
+			while (offset < word_bits)
+			{
+				if (in_run)
+				{
+					//cells past x1 are 0 in cur, so a run always ends there
+					word gaps = ~cur & bits::from(offset);
+					if (!gaps)
+						break;
+					offset = bits::ctz(gaps);
+					f(run_start, base + offset - run_start);
+					in_run = false;
+				}
+				else
+				{
+					word walls = cur & bits::from(offset);
+					if (!walls)
+						break;
+					offset = bits::ctz(walls);
+					run_start = base + offset;
+					in_run = true;
+				}
+			}
+		}
+
+		if (in_run)
+			f(run_start, x1 - run_start);
+	}
+
+	//calls f(x, y, length) for every maximal vertical run of walls in the columns [x0, x1) and rows [y0, y1)
+	//columns are walked 256 at a time, a run is reported when it ends, so runs come out ordered by their last row
+	template <typename F>
+	void vertical_runs(int x0, int x1, int y0, int y1, F &&f) const
+	{
+		x0 = std::max(x0, 0);
+		x1 = std::min(x1, w);
+		y0 = std::max(y0, 0);
+		y1 = std::min(y1, h);
+		if (x1 <= x0 || y1 <= y0)
+			return;
+
+		int first = x0 / word_bits / 4 * 4;
+		int last = (x1 - 1) / word_bits;
+
+		for (int wb = first; wb <= last; wb += 4)
+		{
+			word mask[4];
+			for (int l = 0; l < 4; ++l)
+			{
+				int base = (wb + l) * word_bits;
+				mask[l] = base >= x1 || base + word_bits <= x0 ? 0 : bits::range(std::max(x0 - base, 0), std::min(x1 - base, word_bits));
+			}
+
+			word prev[4] = {0, 0, 0, 0};
+			word starts[4];
+			word ends[4];
+			int start_row[4 * word_bits];
+
+			for (int y = y0; y <= y1; ++y)
+			{
+				word cur[4] = {0, 0, 0, 0};
+				if (y < y1)
+					transitions(row(y) + wb, mask, prev, cur, starts, ends);
+				else
+				{
+					for (int l = 0; l < 4; ++l)
+					{
+						starts[l] = 0;
+						ends[l] = prev[l];
+					}
+				}
+
+				for (int l = 0; l < 4; ++l)
+				{
+					for (word e = ends[l]; e; e &= e - 1)
+					{
+						int b = l * word_bits + bits::ctz(e);
+						f(wb * word_bits + b, start_row[b], y - start_row[b]);
+					}
+					for (word s = starts[l]; s; s &= s - 1)
+						start_row[l * word_bits + bits::ctz(s)] = y;
+
+					prev[l] = cur[l];
+				}
+			}
+		}
+	}
+
+private:
+	int w;
+	int h;
+	int stride;
+
+	std::vector<word> d;
+
+	//calls f(word index, mask of the cells of [x0, x1) in that word)
+	template <typename F>
+	static void for_each_word(int x0, int x1, F &&f)
+	{
+		if (x1 <= x0)
+			return;
+
+		int first = x0 / word_bits;
+		int last = (x1 - 1) / word_bits;
+		for (int wi = first; wi <= last; ++wi)
+		{
+			int base = wi * word_bits;
+			f(wi, bits::range(wi == first ? x0 - base : 0, wi == last ? x1 - base : word_bits));
+		}
+	}
+
+	//cur = masked row words, starts = walls that were open in the previous row, ends = walls of the previous row that are open now
+	static void transitions(const word *r, const word *mask, const word *prev, word *cur, word *starts, word *ends)
+	{
+#if defined(__AVX2__)
+		__m256i c = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(r)), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask)));
+		__m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(prev));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(cur), c);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(starts), _mm256_andnot_si256(p, c));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(ends), _mm256_andnot_si256(c, p));
+#else
+		for (int l = 0; l < 4; ++l)
+		{
+			cur[l] = r[l] & mask[l];
+			starts[l] = cur[l] & ~prev[l];
+			ends[l] = prev[l] & ~cur[l];
+		}
+#endif
+	}
+};
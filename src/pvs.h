@@ -0,0 +1,347 @@
+#pragma once
+#include "visibility.h"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+
+//chunks visible from every block of block_size x block_size cells, baked offline with grid_visibility
+//a block's set is the union of what each of its open cells sees, one bit per chunk of the (2 * radius + 1)^2 window around the block's chunk
+//identical sets are stored once, so the file is a table of distinct sets and run length encoded set indices in block order, runs are varints
+class baked_pvs
+{
+public:
+	using chunk_key = grid_visibility::chunk_key;
+	using word = std::uint64_t;
+
+	//what one lookup returns, valid until the pvs is destroyed
+	struct visible_set
+	{
+		//nullptr means unknown, every chunk is visible
+		const word *bits;
+		chunk_key center;
+		int radius;
+
+		bool chunk_visible(const chunk_key &k) const
+		{
+			if (!bits)
+				return true;
+
+			int x = k.first - center.first + radius;
+			int y = k.second - center.second + radius;
+			int n = 2 * radius + 1;
+			if (x < 0 || y < 0 || x >= n || y >= n)
+				return false;
+
+			int i = y * n + x;
+			return bits[i / 64] >> (i % 64) & 1;
+		}
+	};
+
+	baked_pvs() = default;
+
+	//block_sz is rounded down to a divisor of chunk_sz, thread_count 0 uses every hardware thread
+	//blocks are handed out in order and each result is stored by block index, so the output only depends on the grid and settings
+	static baked_pvs bake(const occupancy_grid &g, int chunk_sz, int chunk_radius, int block_sz, unsigned int thread_count = 0)
+	{
+		block_sz = std::gcd(std::max(block_sz, 1), chunk_sz);
+
+		baked_pvs res;
+		res.w = g.width();
+		res.h = g.height();
+		res.chunk_sz = chunk_sz;
+		res.radius = chunk_radius;
+		res.block_sz = block_sz;
+		res.hash = grid_hash(g);
+		res.blocks_x = (res.w + block_sz - 1) / block_sz;
+		res.blocks_y = (res.h + block_sz - 1) / block_sz;
+
+		int n = 2 * chunk_radius + 1;
+		std::size_t words = res.words_per_set();
+		std::vector<word> block_bits(std::size_t(res.blocks_x) * res.blocks_y * words, 0);
+
+		if (!thread_count)
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+		std::atomic<int> next_block{0};
+		auto work = [&]()
+		{
+			grid_visibility vis(g, chunk_sz, chunk_radius);
+			int b;
+			while ((b = next_block++) < res.blocks_x * res.blocks_y)
+			{
+				int bx = b % res.blocks_x * block_sz;
+				int by = b / res.blocks_x * block_sz;
+				chunk_key center{bx / chunk_sz, by / chunk_sz};
+				word *bits = block_bits.data() + std::size_t(b) * words;
+
+				for (int y = by; y < std::min(by + block_sz, res.h); ++y)
+				{
+					for (int x = bx; x < std::min(bx + block_sz, res.w); ++x)
+					{
+						if (g.wall(x, y))
+							continue;
+
+						vis.update({x, y});
+						for (int i = 0; i < n * n; ++i)
+						{
+							if (vis.chunk_visible({center.first - chunk_radius + i % n, center.second - chunk_radius + i / n}))
+								bits[i / 64] |= word(1) << (i % 64);
+						}
+					}
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (unsigned int i = 1; i < thread_count; ++i)
+			threads.emplace_back(work);
+		work();
+		for (auto &t : threads)
+			t.join();
+
+		//distinct sets numbered in order of first appearance
+		std::map<std::vector<word>, std::uint32_t> ids;
+		res.block_set.resize(std::size_t(res.blocks_x) * res.blocks_y);
+		for (std::size_t b = 0; b < res.block_set.size(); ++b)
+		{
+			std::vector<word> s(block_bits.begin() + b * words, block_bits.begin() + (b + 1) * words);
+			auto it = ids.find(s);
+			if (it == ids.end())
+			{
+				it = ids.emplace(s, (std::uint32_t)ids.size()).first;
+				res.sets.insert(res.sets.end(), s.begin(), s.end());
+			}
+			res.block_set[b] = it->second;
+		}
+
+		return res;
+	}
+
+	//returns false if the file is missing or not a pvs file
+	bool load(const char *file)
+	{
+		FILE *f = fopen(file, "rb");
+		if (!f)
+			return false;
+
+		bool ok = read(f);
+		fclose(f);
+
+		if (!ok)
+			*this = baked_pvs{};
+		return ok;
+	}
+
+	bool save(const char *file) const
+	{
+		FILE *f = fopen(file, "wb");
+		if (!f)
+			return false;
+
+		put(f, magic);
+		for (std::uint32_t v : {std::uint32_t(w), std::uint32_t(h), std::uint32_t(chunk_sz), std::uint32_t(radius), std::uint32_t(block_sz)})
+			put(f, v);
+		put(f, hash);
+
+		put(f, std::uint32_t(sets.size() / words_per_set()));
+		for (word v : sets)
+			put(f, v);
+
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> runs;
+		for (std::uint32_t s : block_set)
+		{
+			if (!runs.empty() && runs.back().second == s)
+				++runs.back().first;
+			else
+				runs.push_back({1, s});
+		}
+
+		put(f, std::uint32_t(runs.size()));
+		for (const auto &[length, s] : runs)
+		{
+			put_varint(f, length);
+			put_varint(f, s);
+		}
+
+		bool ok = !ferror(f);
+		fclose(f);
+		return ok;
+	}
+
+	//true if this was baked from g with the same chunk settings the streamer uses
+	bool matches(const occupancy_grid &g, int chunk_size, int chunk_radius) const
+	{
+		return !block_set.empty() && w == g.width() && h == g.height() && chunk_sz == chunk_size && radius == chunk_radius && hash == grid_hash(g);
+	}
+
+	//chunks visible from cell, cells outside the maze see everything
+	visible_set at(const glm::vec<2, int> &cell) const
+	{
+		chunk_key center{cell.x / std::max(chunk_sz, 1), cell.y / std::max(chunk_sz, 1)};
+		if (block_set.empty() || cell.x < 0 || cell.y < 0 || cell.x >= w || cell.y >= h)
+			return {nullptr, center, radius};
+
+		std::uint32_t s = block_set[std::size_t(cell.y / block_sz) * blocks_x + cell.x / block_sz];
+		return {sets.data() + std::size_t(s) * words_per_set(), center, radius};
+	}
+
+	std::size_t distinct_sets() const
+	{
+		return block_set.empty() ? 0 : sets.size() / words_per_set();
+	}
+
+	std::size_t block_count() const
+	{
+		return block_set.size();
+	}
+
+	//fnv-1a over the grid's words, identifies the maze a pvs was baked from
+	static std::uint64_t grid_hash(const occupancy_grid &g)
+	{
+		std::uint64_t res = 14695981039346656037ull;
+		for (int y = 0; y < g.height(); ++y)
+		{
+			const occupancy_grid::word *r = g.row(y);
+			for (int i = 0; i < g.words_per_row(); ++i)
+			{
+				for (int b = 0; b < 8; ++b)
+				{
+					res ^= r[i] >> (b * 8) & 0xFF;
+					res *= 1099511628211ull;
+				}
+			}
+		}
+		return res;
+	}
+
+private:
+	static constexpr std::uint32_t magic = 0x31535650; //"PVS1"
+
+	int w = 0;
+	int h = 0;
+	int chunk_sz = 0;
+	int radius = 0;
+	int block_sz = 0;
+	int blocks_x = 0;
+	int blocks_y = 0;
+	std::uint64_t hash = 0;
+
+	//distinct sets, words_per_set() words each
+	std::vector<word> sets;
+	//index into sets of every block, row major
+	std::vector<std::uint32_t> block_set;
+
+	std::size_t words_per_set() const
+	{
+		int n = 2 * radius + 1;
+		return (n * n + 63) / 64;
+	}
+
+	//little endian regardless of the host
+	template <typename T>
+	static void put(FILE *f, T v)
+	{
+		unsigned char bytes[sizeof(T)];
+		for (std::size_t i = 0; i < sizeof(T); ++i)
+			bytes[i] = (unsigned char)(v >> (i * 8));
+		fwrite(bytes, 1, sizeof(T), f);
+	}
+
+	template <typename T>
+	static bool get(FILE *f, T &v)
+	{
+		unsigned char bytes[sizeof(T)];
+		if (fread(bytes, 1, sizeof(T), f) != sizeof(T))
+			return false;
+
+		v = 0;
+		for (std::size_t i = 0; i < sizeof(T); ++i)
+			v |= T(bytes[i]) << (i * 8);
+		return true;
+	}
+
+	//7 bits per byte, high bit set on every byte but the last
+	static void put_varint(FILE *f, std::uint32_t v)
+	{
+		while (v >= 0x80)
+		{
+			fputc(int((v & 0x7F) | 0x80), f);
+			v >>= 7;
+		}
+		fputc(int(v), f);
+	}
+
+	static bool get_varint(FILE *f, std::uint32_t &v)
+	{
+		v = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			int c = fgetc(f);
+			if (c == EOF)
+				return false;
+
+			v |= std::uint32_t(c & 0x7F) << shift;
+			if (!(c & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	bool read(FILE *f)
+	{
+		std::uint32_t m;
+		std::uint32_t header[5];
+		if (!get(f, m) || m != magic)
+			return false;
+		for (auto &v : header)
+		{
+			if (!get(f, v))
+				return false;
+		}
+		if (!get(f, hash))
+			return false;
+
+		w = header[0];
+		h = header[1];
+		chunk_sz = header[2];
+		radius = header[3];
+		block_sz = header[4];
+		if (w <= 0 || h <= 0 || chunk_sz <= 0 || radius < 0 || block_sz <= 0)
+			return false;
+
+		blocks_x = (w + block_sz - 1) / block_sz;
+		blocks_y = (h + block_sz - 1) / block_sz;
+
+		std::uint32_t set_count;
+		if (!get(f, set_count))
+			return false;
+		sets.resize(std::size_t(set_count) * words_per_set());
+		for (word &v : sets)
+		{
+			if (!get(f, v))
+				return false;
+		}
+
+		std::uint32_t run_count;
+		if (!get(f, run_count))
+			return false;
+
+		block_set.clear();
+		std::size_t blocks = std::size_t(blocks_x) * blocks_y;
+		for (std::uint32_t i = 0; i < run_count; ++i)
+		{
+			std::uint32_t length;
+			std::uint32_t s;
+			if (!get_varint(f, length) || !get_varint(f, s) || s >= set_count || block_set.size() + length > blocks)
+				return false;
+			block_set.insert(block_set.end(), length, s);
+		}
+
+		return block_set.size() == blocks;
+	}
+};
\ No newline at end of file
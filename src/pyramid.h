@@ -0,0 +1,100 @@
+#pragma once
+#include "occupancy.h"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+//occupancy_grid mip chain, a cell of level k is a wall if any of the 2x2 cells of level k - 1 below it is
+//level 0 is the grid itself, levels are added until the largest side is at most min_size cells so a min_size window shows the whole maze
+class occupancy_pyramid
+{
+public:
+	//thread_count 0 uses every hardware thread, rows of a level are handed out 64 at a time and each level waits for the one before
+	occupancy_pyramid(const occupancy_grid &g, int min_size, unsigned int thread_count = 0) : base{g}
+	{
+		if (!thread_count)
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+		min_size = std::max(min_size, 1);
+
+		//prev points into reduced, so it must never reallocate
+		int count = 0;
+		for (int side = std::max(g.width(), g.height()); side > min_size; side = (side + 1) / 2)
+			++count;
+		reduced.reserve(count);
+
+		for (const occupancy_grid *prev = &base; std::max(prev->width(), prev->height()) > min_size; prev = &reduced.back())
+		{
+			reduced.emplace_back((prev->width() + 1) / 2, (prev->height() + 1) / 2);
+			occupancy_grid &next = reduced.back();
+
+			constexpr int rows_per_job = 64;
+			std::atomic<int> next_row{0};
+			auto work = [&]()
+			{
+				int y0;
+				while ((y0 = next_row.fetch_add(rows_per_job)) < next.height())
+				{
+					for (int y = y0; y < std::min(y0 + rows_per_job, next.height()); ++y)
+						reduce_row(*prev, next, y);
+				}
+			};
+
+			std::vector<std::thread> threads;
+			unsigned int jobs = (next.height() + rows_per_job - 1) / rows_per_job;
+			for (unsigned int i = 1; i < std::min(thread_count, jobs); ++i)
+				threads.emplace_back(work);
+			work();
+			for (auto &t : threads)
+				t.join();
+		}
+	}
+
+	int levels() const
+	{
+		return (int)reduced.size() + 1;
+	}
+
+	const occupancy_grid &level(int i) const
+	{
+		return i ? reduced[i - 1] : base;
+	}
+
+private:
+	const occupancy_grid &base;
+	std::vector<occupancy_grid> reduced;
+
+	//even bits of v packed into the low 32 bits
+	static occupancy_grid::word compact_even(occupancy_grid::word v)
+	{
+		v &= 0x5555555555555555ull;
+		v = (v | v >> 1) & 0x3333333333333333ull;
+		v = (v | v >> 2) & 0x0F0F0F0F0F0F0F0Full;
+		v = (v | v >> 4) & 0x00FF00FF00FF00FFull;
+		v = (v | v >> 8) & 0x0000FFFF0000FFFFull;
+		return (v | v >> 16) & 0x00000000FFFFFFFFull;
+	}
+
+	//row y of dst from rows 2y and 2y + 1 of src, two source words make one destination word
+	static void reduce_row(const occupancy_grid &src, occupancy_grid &dst, int y)
+	{
+		using word = occupancy_grid::word;
+
+		const word *a = src.row(2 * y);
+		const word *b = 2 * y + 1 < src.height() ? src.row(2 * y + 1) : nullptr;
+		word *out = dst.row(y);
+
+		auto pair = [&](int i) -> word
+		{
+			if (i >= src.words_per_row())
+				return 0;
+			word v = a[i] | (b ? b[i] : 0);
+			return compact_even(v | v >> 1);
+		};
+
+		int words = (dst.width() + occupancy_grid::word_bits - 1) / occupancy_grid::word_bits;
+		for (int i = 0; i < words; ++i)
+			out[i] = pair(2 * i) | pair(2 * i + 1) << 32;
+	}
+};
\ No newline at end of file
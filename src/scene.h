@@ -0,0 +1,147 @@
+#pragma once
+#include "object.h"
+#include "shaders.h"
+#include "quad.h"
+#include "camera.h"
+#include "maze_stream.h"
+
+#include "shaders/frag.h"
+#include "shaders/vert.h"
+#include "shaders/box_vert.h"
+#include "shaders/compact_vert.h"
+
+#include <array>
+
+//how playmz draws a maze, playmz_bench draws with the same settings so its numbers are playmz's
+//plain data with no gl objects, playmz hashes it into the cache key before it has a context
+struct scene_settings
+{
+	//world units per maze pixel
+	static constexpr float mpp = .5;
+
+	//maze pixels per streamed chunk, and how many chunks around the player's chunk stay resident
+	static constexpr int chunk_size = 64;
+	static constexpr int chunk_radius = 2;
+
+	scene_settings()
+	{
+		wall_cols.fill(0);
+		for (int i = 0; i < wall_cols.size(); i += 3)
+			wall_cols[i] = 1;
+
+		floor_cols.fill(1.0f);
+
+		wall_model.scale(wall_size);
+
+		stream_opts.mode = maze_loader::mode::greedy;
+		stream_opts.exposed_faces_only = true;
+		stream_opts.merged = true;
+		stream_opts.instanced = false;
+		stream_opts.compact = true;
+	}
+
+	std::array<float, 8 * 3> wall_cols;
+	std::array<float, 8 * 3> floor_cols;
+
+	glm::vec3 wall_size{mpp, 2, mpp};
+	model wall_model;
+
+	stream_options stream_opts;
+};
+
+//the wall and floor programs and the floor of a maze, needs a current context and the vao the floor is drawn with bound
+//walls are drawn with the program matching the streamer's vertex format, the floor always with sp
+class scene_renderer
+{
+public:
+	scene_renderer(const scene_settings &s, const occupancy_grid &maze, const maze_streamer &streamer) : settings{s}, floor_dims{maze.width() * s.mpp, -1, maze.height() * s.mpp}, floor_mesh(glm::vec3(0, 0, 0), floor_dims.x, floor_dims.y, floor_dims.z), floor{make_floor(floor_mesh, s.floor_cols)}
+	{
+		if (s.stream_opts.instanced)
+		{
+			wall_sp = &box_sp;
+			wall_mv = &box_mv;
+			wall_proj = &box_proj;
+		}
+		else if (streamer.compact())
+		{
+			wall_sp = &compact_sp;
+			wall_mv = &compact_mv;
+			wall_proj = &compact_proj;
+
+			compact_sp.use();
+			compact_col.send<3>(1, s.wall_cols.data());
+		}
+	}
+
+	scene_renderer(const scene_renderer &) = delete;
+	scene_renderer &operator=(const scene_renderer &) = delete;
+
+	//the streamer's chunks can be drawn after this
+	void use_walls(const camera &cam)
+	{
+		wall_sp->use();
+		wall_proj->send<4, 4>(1, GL_FALSE, glm::value_ptr(cam.proj_matrix()));
+
+		glm::mat4 mv_mat = cam.view_matrix() * settings.wall_model;
+		wall_mv->send<4, 4>(1, GL_FALSE, glm::value_ptr(mv_mat));
+	}
+
+	//leaves sp in use
+	void draw_floor(const camera &cam)
+	{
+		if (wall_sp != &sp)
+		{
+			sp.use();
+			proj.send<4, 4>(1, GL_FALSE, glm::value_ptr(cam.proj_matrix()));
+		}
+
+		glm::mat4 mv_mat = cam.view_matrix() * floor_model;
+		mv.send<4, 4>(1, GL_FALSE, glm::value_ptr(mv_mat));
+		floor.draw(GL_TRIANGLES);
+	}
+
+	const glm::vec3 &floor_size() const
+	{
+		return floor_dims;
+	}
+
+	std::size_t floor_indices() const
+	{
+		return floor_mesh.indices().size();
+	}
+
+private:
+	static maze_streamer::wall_obj make_floor(const quad &mesh, const std::array<float, 8 * 3> &cols)
+	{
+		return maze_streamer::wall_obj(
+			buffer_data<vbo_target>(mesh.vertices().data(), mesh.vertices().size() / 3, 3, 0, GL_STATIC_DRAW),
+			buffer_data<vbo_target>(cols.data(), cols.size() / 3, 3, 1, GL_STATIC_DRAW),
+			buffer_data<ebo_target>(mesh.indices().data(), mesh.indices().size(), GL_STATIC_DRAW));
+	}
+
+	const scene_settings &settings;
+
+	program sp = make_program(make_shader(vert_src, GL_VERTEX_SHADER), make_shader(frag_src, GL_FRAGMENT_SHADER));
+	uniform mv = sp.get_uniform("mv_mat");
+	uniform proj = sp.get_uniform("proj_mat");
+
+	//walls drawn as instances of a unit box
+	program box_sp = make_program(make_shader(box_vert_src, GL_VERTEX_SHADER), make_shader(frag_src, GL_FRAGMENT_SHADER));
+	uniform box_mv = box_sp.get_uniform("mv_mat");
+	uniform box_proj = box_sp.get_uniform("proj_mat");
+
+	//walls with 16 bit positions and one colour
+	program compact_sp = make_program(make_shader(compact_vert_src, GL_VERTEX_SHADER), make_shader(frag_src, GL_FRAGMENT_SHADER));
+	uniform compact_mv = compact_sp.get_uniform("mv_mat");
+	uniform compact_proj = compact_sp.get_uniform("proj_mat");
+	uniform compact_col = compact_sp.get_uniform("wall_col");
+
+	const program *wall_sp = &sp;
+	uniform *wall_mv = &mv;
+	uniform *wall_proj = &proj;
+
+	glm::vec3 floor_dims;
+	quad floor_mesh;
+	model floor_model;
+	maze_streamer::wall_obj floor;
+};
\ No newline at end of file
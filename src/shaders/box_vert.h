@@ -0,0 +1,20 @@
+const char *box_vert_src = R"(
+#version 430
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 vertex_cols;
+
+//per instance, corner and size of the box
+layout (location = 2) in vec3 offset;
+layout (location = 3) in vec3 extent;
+
+uniform mat4 mv_mat;
+uniform mat4 proj_mat;
+
+out vec4 col;
+
+void main(void){
+    gl_Position = proj_mat * mv_mat * vec4(offset + pos * extent, 1.0);
+    col = vec4(vertex_cols, 1.0);
+}
+)";
\ No newline at end of file
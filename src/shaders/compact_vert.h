@@ -0,0 +1,17 @@
+const char *compact_vert_src = R"(
+#version 430
+
+//16 bit integer positions, every vertex has the same colour
+layout (location = 0) in vec3 pos;
+
+uniform mat4 mv_mat;
+uniform mat4 proj_mat;
+uniform vec3 wall_col;
+
+out vec4 col;
+
+void main(void){
+    gl_Position = proj_mat * mv_mat * vec4(pos, 1.0);
+    col = vec4(wall_col, 1.0);
+}
+)";
\ No newline at end of file
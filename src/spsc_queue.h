@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+//bounded lock-free queue for exactly one producer thread and one consumer thread
+//capacity is rounded up to a power of two, T has to be default constructible and move assignable
+template <typename T>
+class spsc_queue
+{
+public:
+	explicit spsc_queue(std::size_t capacity) : slots(round_up(capacity)), mask{slots.size() - 1}
+	{
+	}
+
+	spsc_queue(const spsc_queue &) = delete;
+	spsc_queue &operator=(const spsc_queue &) = delete;
+
+	//producer only, leaves v untouched and returns false if the queue is full
+	bool try_push(T &&v)
+	{
+		std::size_t t = tail.load(std::memory_order_relaxed);
+		if (t - head_cache == slots.size())
+		{
+			head_cache = head.load(std::memory_order_acquire);
+			if (t - head_cache == slots.size())
+				return false;
+		}
+
+		slots[t & mask] = std::move(v);
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	//consumer only, returns false if the queue is empty
+	bool try_pop(T &out)
+	{
+		std::size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail_cache)
+		{
+			tail_cache = tail.load(std::memory_order_acquire);
+			if (h == tail_cache)
+				return false;
+		}
+
+		out = std::move(slots[h & mask]);
+		slots[h & mask] = T{};
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	//only a snapshot when called from a third thread
+	bool empty() const
+	{
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+	std::size_t capacity() const
+	{
+		return slots.size();
+	}
+
+private:
+	static constexpr std::size_t cache_line = 64;
+
+	std::vector<T> slots;
+	std::size_t mask;
+
+	//consumer side
+	alignas(cache_line) std::atomic<std::size_t> head{0};
+	std::size_t tail_cache = 0;
+
+	//producer side
+	alignas(cache_line) std::atomic<std::size_t> tail{0};
+	std::size_t head_cache = 0;
+
+	static std::size_t round_up(std::size_t n)
+	{
+		std::size_t p = 1;
+		while (p < n)
+			p <<= 1;
+		return p;
+	}
+};
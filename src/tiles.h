@@ -0,0 +1,147 @@
+#pragma once
+#include <GL/glew.h>
+#include "pyramid.h"
+#include <glm/vec2.hpp>
+#include <vector>
+#include <map>
+#include <array>
+#include <tuple>
+#include <algorithm>
+
+//pyramid levels cut into tile_size x tile_size R8 tiles, walls 0 and open cells 255
+//tiles are uploaded into the layers of one texture array only when a view needs them, so the texture stays tile_size^2 * layer_count bytes whatever the maze size
+//when every layer is taken the tile shown least recently is replaced
+class occupancy_tiles
+{
+public:
+	static constexpr int tile_size = 128;
+
+	//layer_count is at least 4, the tiles of one view
+	explicit occupancy_tiles(const occupancy_pyramid &p, int layer_count = 16) : levels{p}, slots(std::max(layer_count, 4))
+	{
+		glGenTextures(1, &id);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_R8, tile_size, tile_size, (GLsizei)slots.size());
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	occupancy_tiles(const occupancy_tiles &) = delete;
+	occupancy_tiles &operator=(const occupancy_tiles &) = delete;
+
+	~occupancy_tiles()
+	{
+		glDeleteTextures(1, &id);
+	}
+
+	//makes the 2x2 tiles of level starting at tile origin resident and returns their layers in row major order, -1 for tiles outside the level
+	//a view at most tile_size cells wide and high never spans more than these
+	std::array<GLint, 4> show(int level, const glm::ivec2 &origin)
+	{
+		++clock;
+
+		const occupancy_grid &g = levels.level(level);
+		int tiles_x = (g.width() + tile_size - 1) / tile_size;
+		int tiles_y = (g.height() + tile_size - 1) / tile_size;
+
+		std::array<GLint, 4> res;
+		for (int i = 0; i < 4; ++i)
+		{
+			tile_key k{level, origin.x + i % 2, origin.y + i / 2};
+			bool inside = std::get<1>(k) >= 0 && std::get<2>(k) >= 0 && std::get<1>(k) < tiles_x && std::get<2>(k) < tiles_y;
+			res[i] = inside ? layer_of(k) : -1;
+		}
+		return res;
+	}
+
+	void use() const
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+	}
+
+	//tiles uploaded so far, every one is a glTexSubImage3D of tile_size^2 bytes
+	std::size_t uploads() const
+	{
+		return upload_count;
+	}
+
+private:
+	//level, tile x, tile y
+	using tile_key = std::tuple<int, int, int>;
+
+	struct slot
+	{
+		tile_key key;
+		unsigned long long last_shown = 0;
+		bool used = false;
+	};
+
+	const occupancy_pyramid &levels;
+	GLuint id;
+
+	std::vector<slot> slots;
+	std::map<tile_key, int> resident;
+	unsigned long long clock = 0;
+	std::size_t upload_count = 0;
+
+	std::vector<unsigned char> cells;
+
+	GLint layer_of(const tile_key &k)
+	{
+		auto it = resident.find(k);
+		if (it != resident.end())
+		{
+			slots[it->second].last_shown = clock;
+			return it->second;
+		}
+
+		//a free layer, else the one shown longest ago, never one shown by this call
+		int layer = 0;
+		for (int i = 1; i < (int)slots.size(); ++i)
+		{
+			if (!slots[layer].used)
+				break;
+			if (!slots[i].used || slots[i].last_shown < slots[layer].last_shown)
+				layer = i;
+		}
+
+		if (slots[layer].used)
+			resident.erase(slots[layer].key);
+
+		upload(k, layer);
+		slots[layer] = {k, clock, true};
+		resident[k] = layer;
+		return layer;
+	}
+
+	void upload(const tile_key &k, int layer)
+	{
+		const occupancy_grid &g = levels.level(std::get<0>(k));
+		int x0 = std::get<1>(k) * tile_size;
+		int y0 = std::get<2>(k) * tile_size;
+
+		//cells past the level's edges are never sampled
+		cells.assign(std::size_t(tile_size) * tile_size, 255);
+		for (int y = 0; y < std::min(tile_size, g.height() - y0); ++y)
+		{
+			unsigned char *dst = cells.data() + std::size_t(y) * tile_size;
+			for (int x = 0; x < tile_size; x += occupancy_grid::word_bits)
+			{
+				occupancy_grid::word walls = g.bits_at(y0 + y, x0 + x);
+				for (; walls; walls &= walls - 1)
+					dst[x + bits::ctz(walls)] = 0;
+			}
+		}
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, tile_size, tile_size, 1, GL_RED, GL_UNSIGNED_BYTE, cells.data());
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		++upload_count;
+	}
+};
\ No newline at end of file
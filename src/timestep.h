@@ -0,0 +1,93 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+//runs a simulation at a fixed rate however often it is advanced
+//leftover time carries over to the next advance, and the fraction of a tick left is what rendering interpolates with
+class fixed_timestep
+{
+public:
+	//at most max_steps ticks run per advance, time beyond that is dropped so a long stall can't snowball
+	fixed_timestep(double ticks_per_second, int max_steps = 8) : dt{1 / ticks_per_second}, max{max_steps}
+	{
+	}
+
+	//calls step(tick length) once per whole tick in elapsed plus the carried over time
+	//returns how far into the next tick the simulation is, from 0 to 1
+	template <typename F>
+	float advance(double elapsed, F &&step)
+	{
+		acc += elapsed;
+
+		int steps = 0;
+		while (acc >= dt && steps < max)
+		{
+			step((float)dt);
+			acc -= dt;
+			++steps;
+		}
+
+		if (steps == max)
+			acc = std::min(acc, dt);
+
+		return (float)(acc / dt);
+	}
+
+	//forgets the carried over time, call after a pause
+	void reset()
+	{
+		acc = 0;
+	}
+
+	double tick() const
+	{
+		return dt;
+	}
+
+private:
+	double dt;
+	int max;
+	double acc = 0;
+};
+
+//caps a loop at a fixed rate, sleeps through most of the time left and spins the last stretch because sleeps overshoot
+class frame_limiter
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	//0 doesn't cap
+	explicit frame_limiter(double frames_per_second) : period{frames_per_second > 0 ? std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1 / frames_per_second)) : clock::duration::zero()}, next{clock::now()}
+	{
+	}
+
+	//blocks until one period after the last frame, a frame that ran long doesn't make the next ones shorter
+	void wait()
+	{
+		if (period == clock::duration::zero())
+			return;
+
+		clock::time_point now = clock::now();
+		next = std::max(next + period, now);
+
+		clock::time_point spin_from = next - spin;
+		if (now < spin_from)
+			std::this_thread::sleep_until(spin_from);
+		while (clock::now() < next)
+			std::this_thread::yield();
+	}
+
+	//in seconds, 0 if uncapped
+	double frame_time() const
+	{
+		return std::chrono::duration<double>(period).count();
+	}
+
+private:
+	//longer than the usual sleep overshoot
+	static constexpr clock::duration spin = std::chrono::microseconds(1500);
+
+	clock::duration period;
+	clock::time_point next;
+};
\ No newline at end of file
@@ -0,0 +1,186 @@
+#pragma once
+#include "occupancy.h"
+#include <glm/vec2.hpp>
+#include <glm/gtc/constants.hpp>
+#include <vector>
+#include <utility>
+#include <cmath>
+#include <algorithm>
+
+//cells of the maze that can be seen from the player's cell, walls are taller than the player so nothing is seen past them
+//found by casting 2d rays through the grid from the centre and corners of the cell, only chunks within chunk_radius of it are considered
+class grid_visibility
+{
+public:
+	using chunk_key = std::pair<int, int>;
+
+	grid_visibility(const occupancy_grid &maze_grid, int chunk_sz, int chunk_radius) : mz{maze_grid}, size{chunk_sz}, radius{chunk_radius}
+	{
+		set_radius(chunk_radius);
+	}
+
+	//recasts if cell moved, returns true if it did
+	//a cell outside the maze sees every cell and chunk in the window
+	bool update(const glm::vec<2, int> &cell)
+	{
+		if (valid && cell == from)
+			return false;
+
+		from = cell;
+		valid = true;
+
+		origin = {floor_div(cell.x, size) * size - radius * size, floor_div(cell.y, size) * size - radius * size};
+		seen.set_rect(0, 0, span, span, false);
+		std::fill(chunks_seen.begin(), chunks_seen.end(), 0);
+		chunk_count = 0;
+
+		//rays from outside the maze never enter it, like baked_pvs everything in the window is visible from there
+		if (cell.x < 0 || cell.y < 0 || cell.x >= mz.width() || cell.y >= mz.height())
+		{
+			seen.set_rect(0, 0, span, span, true);
+			std::fill(chunks_seen.begin(), chunks_seen.end(), 1);
+			chunk_count = chunks_seen.size();
+			return true;
+		}
+
+		constexpr float e = .01f;
+		const glm::vec2 starts[5] = {
+			glm::vec2(cell) + .5f,
+			glm::vec2(cell) + glm::vec2(e, e),
+			glm::vec2(cell) + glm::vec2(1 - e, e),
+			glm::vec2(cell) + glm::vec2(e, 1 - e),
+			glm::vec2(cell) + glm::vec2(1 - e, 1 - e)};
+
+		for (const auto &s : starts)
+		{
+			for (const auto &d : dirs)
+				cast(s, d);
+		}
+		return true;
+	}
+
+	//forgets the last cell so the next update recasts, call after the grid changed
+	void invalidate()
+	{
+		valid = false;
+	}
+
+	void set_radius(int chunk_radius)
+	{
+		radius = chunk_radius;
+		span = (2 * radius + 1) * size;
+		chunks_seen.assign((2 * radius + 1) * (2 * radius + 1), 0);
+		seen = occupancy_grid(span, span);
+
+		//enough rays that neighbours are less than half a cell apart at the edge of the window
+		int rays = std::max(64, (int)std::ceil(2 * glm::pi<float>() * span * 2));
+		dirs.resize(rays);
+		for (int i = 0; i < rays; ++i)
+		{
+			float a = 2 * glm::pi<float>() * i / rays;
+			dirs[i] = glm::vec2(std::cos(a), std::sin(a));
+		}
+		valid = false;
+	}
+
+	//cells outside the window are never visible
+	bool cell_visible(int x, int y) const
+	{
+		x -= origin.x;
+		y -= origin.y;
+		return x >= 0 && y >= 0 && x < span && y < span && seen.wall(x, y);
+	}
+
+	bool chunk_visible(const chunk_key &k) const
+	{
+		int x = k.first - origin.x / size;
+		int y = k.second - origin.y / size;
+		int n = 2 * radius + 1;
+		return x >= 0 && y >= 0 && x < n && y < n && chunks_seen[y * n + x];
+	}
+
+	std::size_t visible_chunks() const
+	{
+		return chunk_count;
+	}
+
+	std::size_t visible_cells() const
+	{
+		return seen.count();
+	}
+
+private:
+	const occupancy_grid &mz;
+	int size;
+	int radius;
+	int span;
+
+	//last cell cast from and the maze cell at the window's top left
+	glm::vec<2, int> from;
+	glm::vec<2, int> origin;
+	bool valid = false;
+
+	//one bit per window cell
+	occupancy_grid seen;
+	std::vector<char> chunks_seen;
+	std::size_t chunk_count = 0;
+
+	std::vector<glm::vec2> dirs;
+
+	static int floor_div(int a, int b)
+	{
+		return a / b - (a % b < 0);
+	}
+
+	void mark(int x, int y)
+	{
+		int lx = x - origin.x;
+		int ly = y - origin.y;
+		if (seen.wall(lx, ly))
+			return;
+		seen.set(lx, ly, true);
+
+		int n = 2 * radius + 1;
+		char &c = chunks_seen[ly / size * n + lx / size];
+		if (!c)
+		{
+			c = 1;
+			++chunk_count;
+		}
+	}
+
+	//walks the cells crossed by the ray from p along d until it enters a wall or leaves the window or the maze
+	void cast(const glm::vec2 &p, const glm::vec2 &d)
+	{
+		int x = (int)std::floor(p.x);
+		int y = (int)std::floor(p.y);
+
+		int step_x = d.x < 0 ? -1 : 1;
+		int step_y = d.y < 0 ? -1 : 1;
+
+		//ray length to cross one cell, and to reach the next vertical and horizontal grid line
+		float delta_x = d.x ? std::abs(1 / d.x) : INFINITY;
+		float delta_y = d.y ? std::abs(1 / d.y) : INFINITY;
+		float next_x = d.x ? ((step_x > 0 ? x + 1 - p.x : p.x - x) * delta_x) : INFINITY;
+		float next_y = d.y ? ((step_y > 0 ? y + 1 - p.y : p.y - y) * delta_y) : INFINITY;
+
+		while (x >= origin.x && y >= origin.y && x < origin.x + span && y < origin.y + span &&
+			   x >= 0 && y >= 0 && x < mz.width() && y < mz.height())
+		{
+			mark(x, y);
+			if (mz.wall(x, y))
+				return;
+
+			if (next_x < next_y)
+			{
+				next_x += delta_x;
+				x += step_x;
+			}
+			else
+			{
+				next_y += delta_y;
+				y += step_y;
+			}
+		}
+	}
+};
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "visibility.h"
+#include <iostream>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		std::cerr << "failed: " << what << "\n";
+		++failures;
+	}
+}
+
+//grid_visibility from cells inside and outside a 256x256 maze with 64 pixel chunks and a chunk radius of 2
+int main()
+{
+	occupancy_grid maze(256, 256);
+
+	//a closed 3x3 room around cell (101, 101), in chunk (1, 1)
+	maze.set_rect(100, 100, 3, 3, true);
+	maze.set(101, 101, false);
+
+	grid_visibility pvs(maze, 64, 2);
+
+	//where playmz spawns the player, above and left of the maze
+	pvs.update({-4, -4});
+	check(pvs.chunk_visible({0, 0}), "chunk (0, 0) visible from (-4, -4)");
+	check(pvs.chunk_visible({1, 1}), "chunk (1, 1) visible from (-4, -4)");
+	check(pvs.visible_chunks() == 25, "every window chunk visible from (-4, -4)");
+	check(pvs.cell_visible(0, 0), "cell (0, 0) visible from (-4, -4)");
+
+	pvs.update({300, 10});
+	check(pvs.chunk_visible({3, 0}), "chunk (3, 0) visible from (300, 10)");
+	check(pvs.visible_chunks() == 25, "every window chunk visible from (300, 10)");
+
+	//rays from inside the room stop at its walls
+	pvs.update({101, 101});
+	check(pvs.chunk_visible({1, 1}), "own chunk visible from inside the room");
+	check(!pvs.chunk_visible({0, 0}), "chunk (0, 0) hidden from inside the room");
+	check(pvs.visible_chunks() == 1, "only the room's chunk visible from inside it");
+	check(pvs.cell_visible(101, 101) && pvs.cell_visible(100, 101), "the room and its walls visible from inside it");
+	check(!pvs.cell_visible(99, 101) && !pvs.cell_visible(101, 103), "nothing past the room's walls visible from inside it");
+
+	pvs.update({-4, -4});
+	check(pvs.visible_chunks() == 25, "every window chunk visible again after leaving the maze");
+
+	if (!failures)
+		std::cout << "all passed\n";
+	return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#pragma once
+#include "spsc_queue.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <limits>
+
+//runs work(job) on background threads
+//every worker owns a job queue and a result queue, both spsc, so submit and drain must be called from one thread only
+template <typename Job, typename Result>
+class worker_pool
+{
+public:
+	worker_pool(unsigned int thread_count, std::function<Result(const Job &)> work, std::size_t queue_capacity = 64) : fn{std::move(work)}
+	{
+		if (thread_count == 0)
+			thread_count = 1;
+
+		for (unsigned int i = 0; i < thread_count; ++i)
+			workers.emplace_back(std::make_unique<worker>(queue_capacity));
+
+		for (auto &w : workers)
+			w->thread = std::thread(&worker_pool::run, this, w.get());
+	}
+
+	worker_pool(const worker_pool &) = delete;
+	worker_pool &operator=(const worker_pool &) = delete;
+
+	~worker_pool()
+	{
+		for (auto &w : workers)
+		{
+			{
+				std::lock_guard<std::mutex> lock(w->m);
+				w->stop = true;
+			}
+			w->wake.notify_one();
+		}
+
+		for (auto &w : workers)
+			w->thread.join();
+	}
+
+	//hands j to the next worker with room in its queue, returns false if every queue is full
+	bool submit(Job &&j)
+	{
+		for (std::size_t tries = 0; tries < workers.size(); ++tries)
+		{
+			worker &w = *workers[next_submit];
+			next_submit = (next_submit + 1) % workers.size();
+
+			if (w.jobs.try_push(std::move(j)))
+			{
+				++in_flight;
+
+				//taking the lock orders the push before the worker's wait predicate so the wakeup can't be lost
+				{
+					std::lock_guard<std::mutex> lock(w.m);
+				}
+				w.wake.notify_one();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//calls f on up to max finished results without blocking, returns how many were handled
+	template <typename F>
+	std::size_t drain(F &&f, std::size_t max = std::numeric_limits<std::size_t>::max())
+	{
+		std::size_t handled = 0;
+		Result r;
+
+		for (std::size_t i = 0; i < workers.size() && handled < max; ++i)
+		{
+			worker &w = *workers[next_drain];
+			next_drain = (next_drain + 1) % workers.size();
+
+			while (handled < max && w.results.try_pop(r))
+			{
+				--in_flight;
+				++handled;
+				f(std::move(r));
+			}
+		}
+		return handled;
+	}
+
+	//jobs submitted whose results have not been drained yet
+	std::size_t pending() const
+	{
+		return in_flight;
+	}
+
+	std::size_t thread_count() const
+	{
+		return workers.size();
+	}
+
+private:
+	struct worker
+	{
+		worker(std::size_t capacity) : jobs{capacity}, results{capacity} {}
+
+		spsc_queue<Job> jobs;
+		spsc_queue<Result> results;
+
+		std::mutex m;
+		std::condition_variable wake;
+		bool stop = false;
+
+		std::thread thread;
+	};
+
+	std::function<Result(const Job &)> fn;
+	std::vector<std::unique_ptr<worker>> workers;
+
+	std::size_t next_submit = 0;
+	std::size_t next_drain = 0;
+	std::size_t in_flight = 0;
+
+	void run(worker *w)
+	{
+		Job j;
+		while (true)
+		{
+			if (!w->jobs.try_pop(j))
+			{
+				std::unique_lock<std::mutex> lock(w->m);
+				w->wake.wait(lock, [w]
+							 { return w->stop || !w->jobs.empty(); });
+				if (w->stop)
+					return;
+				continue;
+			}
+
+			//jobs still queued at shutdown are dropped rather than run, so the destructor waits for at most one job per worker
+			if (stopping(w))
+				return;
+
+			Result r = fn(j);
+
+			//the render thread drains results every frame, so a full queue only means it is behind
+			while (!w->results.try_push(std::move(r)))
+			{
+				if (stopping(w))
+					return;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+	}
+
+	static bool stopping(worker *w)
+	{
+		std::lock_guard<std::mutex> lock(w->m);
+		return w->stop;
+	}
+};